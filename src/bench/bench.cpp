@@ -0,0 +1,425 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <memory>
+
+#include "mesh.hpp"
+#include "objParser.hpp"
+#include "meshArchive.hpp"
+#include "mappedFile.hpp"
+#include "vector3.hpp"
+#include "vector3Batch.hpp"
+#include "utils.hpp"
+#include "constants.hpp"
+
+/**
+ * The benchmarks of the mesh library, run from the root of the repository:
+ *   ./bench.app                       run every benchmark on the default meshes
+ *   ./bench.app <benchmark> [files]   run one benchmark on the given obj files
+*/
+
+namespace{
+
+const std::vector<std::string> DEFAULT_OBJECTS = {"media/objects/garg.obj", "media/objects/bunny.obj"};
+
+/**
+ * The default meshes of the collapse, the quad mesh of garg trips an assertion of the collapse
+*/
+const std::vector<std::string> COLLAPSE_OBJECTS = {"media/objects/bunny.obj"};
+
+const int NB_RUNS = 3;
+
+/**
+ * The number of diagonals collapsed by the collapse benchmark
+*/
+const int NB_COLLAPSES = 200;
+
+/**
+ * The number of faces of the synthetic torus
+*/
+const int TORUS_FACES = 2000000;
+
+/**
+ * Time the fastest of several runs
+ * @param nbRuns The number of runs
+ * @param setup Called before each run, not timed
+ * @param run The function to time
+ * @return The time of the fastest run in milliseconds
+*/
+double bestTime(int nbRuns, const std::function<void()> & setup, const std::function<void()> & run){
+    double best = INFINITY;
+    for(int i=0; i<nbRuns; i++){
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+/**
+ * Read the vertices and faces of an obj file
+ * @param file The obj file
+ * @return Its content
+*/
+mesh::RawMesh readObj(const std::string & file){
+    mesh::RawMesh raw;
+    utils::MappedFile objFile(file);
+    mesh::ObjParser::parse(objFile.begin(), objFile.end(), raw);
+    return raw;
+}
+
+/**
+ * The vertices and faces of an obj file as the stream parser reads them
+*/
+struct StreamContent{
+    std::vector<maths::Vector3*> vertices;
+    std::vector<std::vector<int>> faces;
+
+    ~StreamContent(){
+        for(maths::Vector3* v : vertices) delete v;
+    }
+};
+
+/**
+ * Read an obj file line by line with streams, as loadOBJ did before the in place parser
+ * @param file The obj file
+ * @param content Filled with the vertices and faces
+*/
+void streamParse(const std::string & file, StreamContent & content){
+    std::ifstream objFile(file.c_str());
+    if (!objFile){
+        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
+        throw std::invalid_argument("Need a file as input!\n");
+    }
+    std::string line;
+    while (std::getline(objFile, line)){
+        if (line.length() < 2) continue;
+        else if (line[0] == 'v' && line[1] == ' '){
+            line.erase(line.begin());
+            std::istringstream iss(line);
+            float x,y,z;
+            iss >> x >> y >> z;
+            content.vertices.push_back(new maths::Vector3(x,y,z));
+        }
+        else if (line[0] == 'f'){
+            line.erase(line.begin());
+            content.faces.resize(content.faces.size() + 1);
+            std::istringstream iss(line);
+            int idx;
+            char binBSlash;
+            int binIdx;
+            if (line.find("/") == std::string::npos){
+                while (iss >> idx) content.faces.back().push_back(idx - 1);
+            } else {
+                while (iss >> idx >> binBSlash >> binIdx >> binBSlash >> binIdx) content.faces.back().push_back(idx - 1);
+            }
+        }
+    }
+}
+
+/**
+ * Make a closed torus of triangles
+ * @param nbFaces The number of faces, rounded to a square grid
+ * @return The vertices and faces of the torus
+*/
+mesh::RawMesh makeTorus(int nbFaces){
+    int n = int(std::sqrt(nbFaces / 2.0));
+    mesh::RawMesh raw;
+    for(int i=0; i<n; i++){
+        float u = 2.0f * float(M_PI) * i / n;
+        for(int j=0; j<n; j++){
+            float v = 2.0f * float(M_PI) * j / n;
+            raw.coords.insert(raw.coords.end(), {(2.0f + std::cos(v)) * std::cos(u), (2.0f + std::cos(v)) * std::sin(u), std::sin(v)});
+        }
+    }
+    for(int i=0; i<n; i++){
+        for(int j=0; j<n; j++){
+            int v00 = i*n + j;
+            int v10 = ((i+1)%n)*n + j;
+            int v01 = i*n + (j+1)%n;
+            int v11 = ((i+1)%n)*n + (j+1)%n;
+            raw.indices.insert(raw.indices.end(), {v00, v10, v11, v00, v11, v01});
+            raw.offsets.push_back(raw.offsets.back() + 3);
+            raw.offsets.push_back(raw.offsets.back() + 3);
+        }
+    }
+    return raw;
+}
+
+/**
+ * Time the connectivity build of objToMesh alone, the parsing and the fitmaps are left out
+ * @param name The name of the mesh
+ * @param raw Its vertices and faces
+ * @param nbRuns The number of runs
+*/
+void benchConnectivity(const std::string & name, const mesh::RawMesh & raw, int nbRuns){
+    double time = bestTime(nbRuns, [](){}, [&](){
+        mesh::Mesh::objToMesh(raw);
+    });
+    std::printf("connectivity  %-24s %9d faces %10.1f ms\n", name.c_str(), raw.nbFaces(), time);
+}
+
+/**
+ * Benchmark the connectivity build on obj files and on a synthetic torus
+ * @param files The obj files
+*/
+void connectivity(const std::vector<std::string> & files){
+    for(const std::string & file : files) benchConnectivity(file, readObj(file), NB_RUNS);
+    benchConnectivity("synthetic torus", makeTorus(TORUS_FACES), 1);
+}
+
+/**
+ * Benchmark the parsing alone, the in place parser against the stream one it replaced
+ * @param files The obj files
+*/
+void parse(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        mesh::RawMesh raw;
+        double inPlace = bestTime(NB_RUNS, [&](){ raw = mesh::RawMesh(); }, [&](){
+            utils::MappedFile objFile(file);
+            mesh::ObjParser::parse(objFile.begin(), objFile.end(), raw);
+        });
+        double chunked = bestTime(NB_RUNS, [&](){ raw = mesh::RawMesh(); }, [&](){
+            utils::MappedFile objFile(file);
+            mesh::ObjParser::parseParallel(objFile.begin(), objFile.end(), raw);
+        });
+        std::unique_ptr<StreamContent> content;
+        double stream = bestTime(NB_RUNS, [&](){ content.reset(new StreamContent()); }, [&](){
+            streamParse(file, *content);
+        });
+        std::printf("parse         %-24s %8.1f ms streams %8.1f ms in place (%4.1fx) %8.1f ms in chunks on %d threads\n",
+            file.c_str(), stream, inPlace, stream / inPlace, chunked, utils::nbThreads());
+    }
+}
+
+/**
+ * Benchmark the decoding of an archive level against the parsing of the obj file it was encoded from
+ * @param files The obj files
+*/
+void archive(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        mesh::RawMesh source = readObj(file);
+        float min[3] = {INFINITY, INFINITY, INFINITY};
+        float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for(int i=0; i<source.nbVertices(); i++){
+            for(int j=0; j<3; j++){
+                min[j] = std::min(min[j], source.coords[3*i+j]);
+                max[j] = std::max(max[j], source.coords[3*i+j]);
+            }
+        }
+        std::string level;
+        mesh::MeshArchive::encode(source, min, max, 16, level);
+
+        mesh::RawMesh raw;
+        double parse = bestTime(NB_RUNS, [&](){ raw = mesh::RawMesh(); }, [&](){
+            utils::MappedFile objFile(file);
+            mesh::ObjParser::parse(objFile.begin(), objFile.end(), raw);
+        });
+        double decode = bestTime(NB_RUNS, [&](){ raw = mesh::RawMesh(); }, [&](){
+            const char* cur = level.data();
+            mesh::MeshArchive::decode(cur, level.data() + level.size(), raw);
+        });
+        std::printf("archive       %-24s %6.2f MB obj %8.1f ms parse %6.2f MB archive %8.1f ms decode (%4.1fx)\n",
+            file.c_str(), utils::MappedFile(file).size() / 1e6, parse, level.size() / 1e6, decode, parse / decode);
+    }
+}
+
+/**
+ * Load an obj file with the fitmaps built without the cache
+ * @param file The obj file
+ * @param reorder True to build the mesh in Z-order and reorder it at the end of triToQuad
+ * @return The mesh
+*/
+std::unique_ptr<mesh::Mesh> load(const std::string & file, bool reorder = false){
+    mesh::LoadOptions options;
+    options.fitmapsCache = false;
+    options.reorder = reorder;
+    return std::unique_ptr<mesh::Mesh>(new mesh::Mesh(mesh::Mesh::loadOBJ(file, options)));
+}
+
+/**
+ * Benchmark the load, fitmaps included, and triToQuad
+ * @param files The obj files
+*/
+void quad(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        std::unique_ptr<mesh::Mesh> mesh;
+        double loading = bestTime(NB_RUNS, [](){}, [&](){ mesh = load(file); });
+        double quad = bestTime(NB_RUNS, [&](){ mesh = load(file); }, [&](){ mesh->triToQuad(); });
+        std::printf("quad          %-24s %8.1f ms load %8.1f ms triToQuad\n", file.c_str(), loading, quad);
+    }
+}
+
+/**
+ * Benchmark the diagonal collapse of the quad meshes, the heap's initialization and the final clean included
+ * @param files The obj files
+*/
+void collapse(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        std::unique_ptr<mesh::Mesh> mesh;
+        double time = bestTime(NB_RUNS, [&](){ mesh = load(file); mesh->triToQuad(); }, [&](){
+            mesh->initDiagonals();
+            for(int i=0; i<NB_COLLAPSES; i++){
+                int status;
+                while((status = mesh->diagonalCollapse()) == NO_UPDATE);
+                if (status == EMPTY_HEAP) break;
+            }
+            mesh->clean();
+        });
+        std::printf("collapse      %-24s %8.1f ms %d collapses\n", file.c_str(), time, NB_COLLAPSES);
+    }
+}
+
+/**
+ * Get the mean squareness of the faces of a mesh
+ * @param mesh The mesh
+ * @return The mean sum of the absolute cosines of the faces' corners, 0 for squares
+*/
+double meanSquareness(const mesh::Mesh & mesh){
+    double sum = 0.0;
+    for(const mesh::Face* f : mesh.mFaces){
+        std::vector<maths::Vector3> corners;
+        for(const mesh::Vertex* v : f->getSurroundingVertices()) corners.push_back(v->mCoords);
+        sum += maths::Vector3Batch::sumCornerCosines(corners.data(), int(corners.size()));
+    }
+    return sum / mesh.mNbFaces;
+}
+
+/**
+ * Benchmark triToQuad with the greedy pairing of the triangles and with the parallel matching
+ * @param files The obj files
+*/
+void pairing(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        for(bool isParallel : {false, true}){
+            std::unique_ptr<mesh::Mesh> mesh;
+            double quad = bestTime(NB_RUNS, [&](){ mesh = load(file); mesh->setParallelPairing(isParallel); }, [&](){
+                mesh->triToQuad();
+            });
+            std::printf("pairing %-8s %-24s %8.1f ms triToQuad %9d quads %8.4f mean squareness\n",
+                isParallel ? "matching" : "greedy", file.c_str(), quad, mesh->mNbFaces, meanSquareness(*mesh));
+        }
+    }
+}
+
+/**
+ * The number of empty loops timed by the parallel benchmark
+*/
+const int NB_LOOPS = 10000;
+
+/**
+ * Benchmark triToQuad, whose candidates are scored in parallel, and the cost of starting a parallel loop
+ * @param files The obj files
+*/
+void parallel(const std::vector<std::string> & files){
+    double loop = bestTime(NB_RUNS, [](){}, [](){
+        for(int i=0; i<NB_LOOPS; i++) utils::parallelFor(utils::nbThreads(), [](int){});
+    });
+    std::printf("parallel      %d threads %8.2f us per empty loop\n", utils::nbThreads(), loop * 1000.0 / NB_LOOPS);
+    for(const std::string & file : files){
+        std::unique_ptr<mesh::Mesh> mesh;
+        double quad = bestTime(NB_RUNS, [&](){ mesh = load(file); }, [&](){ mesh->triToQuad(); });
+        std::printf("parallel      %-24s %8.1f ms triToQuad on %d threads\n", file.c_str(), quad, utils::nbThreads());
+    }
+}
+
+/**
+ * Fill the vertex and index buffers of a mesh as scene::Object does before sending them to the GPU
+ * @param mesh The mesh
+ * @param vertices Filled with the coordinates and fitmaps of the vertices
+ * @param indices Filled with the vertices' indices of the faces' triangles
+*/
+void fillBuffers(const mesh::Mesh & mesh, std::vector<float> & vertices, std::vector<unsigned int> & indices){
+    vertices.clear();
+    indices.clear();
+    const mesh::AttributeChannel<float>* sFitmaps = mesh.vertexAttributes().find<float>(mesh::Mesh::S_FITMAP);
+    const mesh::AttributeChannel<float>* mFitmaps = mesh.vertexAttributes().find<float>(mesh::Mesh::M_FITMAP);
+    for(int i=0; i<mesh.mNbVertices; i++){
+        const maths::Vector3 & p = mesh.mVertices[i]->mCoords;
+        vertices.insert(vertices.end(), {p.x(), p.y(), p.z(), sFitmaps ? (*sFitmaps)[i] : 0.0f, mFitmaps ? (*mFitmaps)[i] : 0.0f});
+    }
+    for(const mesh::Face* f : mesh.mFaces){
+        std::vector<mesh::Vertex*> faceVertices = f->getSurroundingVertices();
+        for(int j=1; j+1<int(faceVertices.size()); j++){
+            indices.insert(indices.end(), {unsigned(faceVertices[0]->mSlot), unsigned(faceVertices[j]->mSlot), unsigned(faceVertices[j+1]->mSlot)});
+        }
+    }
+}
+
+/**
+ * Benchmark the load, triToQuad, the render buffer's walk and the collapse without and with the Z-order reordering
+ * @param files The obj files
+*/
+void reorder(const std::vector<std::string> & files){
+    for(const std::string & file : files){
+        for(bool isReordered : {false, true}){
+            std::unique_ptr<mesh::Mesh> mesh;
+            double loading = bestTime(NB_RUNS, [](){}, [&](){ mesh = load(file, isReordered); });
+            double quad = bestTime(NB_RUNS, [&](){ mesh = load(file, isReordered); }, [&](){ mesh->triToQuad(); });
+            std::vector<float> vertices;
+            std::vector<unsigned int> indices;
+            double buffer = bestTime(NB_RUNS, [](){}, [&](){ fillBuffers(*mesh, vertices, indices); });
+            double collapse = bestTime(NB_RUNS, [&](){ mesh = load(file, isReordered); mesh->triToQuad(); }, [&](){
+                mesh->initDiagonals();
+                for(int i=0; i<NB_COLLAPSES; i++){
+                    int status;
+                    while((status = mesh->diagonalCollapse()) == NO_UPDATE);
+                    if (status == EMPTY_HEAP) break;
+                }
+                mesh->clean();
+            });
+            std::printf("reorder %-3s   %-24s %8.1f ms load %8.1f ms triToQuad %8.1f ms buffer %8.1f ms collapse\n",
+                isReordered ? "on" : "off", file.c_str(), loading, quad, buffer, collapse);
+        }
+    }
+}
+
+/**
+ * A benchmark
+*/
+struct Benchmark{
+    const char* name;
+    const char* description;
+    void (*run)(const std::vector<std::string> & files);
+    const std::vector<std::string> & defaultFiles;
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"connectivity", "objToMesh on the files and on a 2M faces torus", connectivity, DEFAULT_OBJECTS},
+    {"parse", "the obj parser alone, sequential and in chunks, against the stream parser", parse, DEFAULT_OBJECTS},
+    {"archive", "the decoding of a 16 bits archive level against the obj parser", archive, DEFAULT_OBJECTS},
+    {"quad", "the load with the fitmaps and triToQuad", quad, DEFAULT_OBJECTS},
+    {"collapse", "200 diagonal collapses of the quad meshes", collapse, COLLAPSE_OBJECTS},
+    {"parallel", "triToQuad with the parallel scoring and the cost of an empty parallel loop", parallel, DEFAULT_OBJECTS},
+    {"pairing", "triToQuad with the greedy pairing and with the parallel matching", pairing, DEFAULT_OBJECTS},
+    {"reorder", "the load, triToQuad, the buffer and the collapse without and with the Z-order", reorder, COLLAPSE_OBJECTS},
+};
+
+}
+
+int main(int argc, char** argv){
+    std::vector<std::string> files;
+    for(int i=2; i<argc; i++) files.push_back(argv[i]);
+
+    bool found = false;
+    for(const Benchmark & benchmark : BENCHMARKS){
+        if (argc > 1 && std::string(argv[1]) != benchmark.name) continue;
+        benchmark.run(files.empty() ? benchmark.defaultFiles : files);
+        found = true;
+    }
+    if (!found){
+        std::fprintf(stderr, "Usage: %s [benchmark] [obj files]\n", argv[0]);
+        for(const Benchmark & benchmark : BENCHMARKS) std::fprintf(stderr, "  %-14s %s\n", benchmark.name, benchmark.description);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -111,8 +111,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv){
     ImGui::FileBrowser fileDialog;
     
     // (optional) set browser properties
-    fileDialog.SetTitle("Select Mesh (*.obj)");
-    fileDialog.SetTypeFilters({ ".obj" });
+    fileDialog.SetTitle("Select Mesh (*.obj, *.ply)");
+    fileDialog.SetTypeFilters({ ".obj", ".ply" });
 
 
     opengl::ResourceManager::loadShader("src/shaders/vert.glsl", "src/shaders/frag.glsl", "objectShader");
@@ -15,8 +15,10 @@ enum VecType {COLOR, POS};
 
 /**
  * A class to represent 3d vectors
+ * The vectors are values aligned on 16 bytes, so the operations never allocate
+ * and a vector is loaded in a single SIMD register
 */
-class Vector3{
+class alignas(16) Vector3{
 
     private:
         /**
@@ -158,7 +160,7 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator + (const Vector3 & v) const{
-            return * new Vector3(x() + v.x(), y() + v.y(), z() + v.z());
+            return Vector3(x() + v.x(), y() + v.y(), z() + v.z());
         };
 
         /**
@@ -167,7 +169,7 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator - (const Vector3 & v) const{
-            return * new Vector3(x() - v.x(), y() - v.y(), z() - v.z());
+            return Vector3(x() - v.x(), y() - v.y(), z() - v.z());
         };
 
         /**
@@ -176,7 +178,7 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator * (const float & f) const{
-            return * new Vector3(x()*f, y()*f, z()*f);
+            return Vector3(x()*f, y()*f, z()*f);
         };
 
         /**
@@ -185,7 +187,7 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator * (const Vector3 & v) const{
-            return * new Vector3(x()*v.x(), y()*v.y(), z()*v.z());
+            return Vector3(x()*v.x(), y()*v.y(), z()*v.z());
         };
 
         /**
@@ -194,7 +196,7 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator / (const float & f) const{
-            return * new Vector3(x()/f, y()/f, z()/f);
+            return Vector3(x()/f, y()/f, z()/f);
         };
 
         /**
@@ -203,7 +205,47 @@ class Vector3{
          * @return The new vector
         */
         Vector3 operator / (const Vector3 & v) const{
-            return * new Vector3(x()/v.x(), y()/v.y(), z()/v.z());
+            return Vector3(x()/v.x(), y()/v.y(), z()/v.z());
+        };
+
+        /**
+         * Vector addition in place
+         * @param v The second vector
+         * @return The vector
+        */
+        Vector3 & operator += (const Vector3 & v){
+            mVect[0] += v.x(); mVect[1] += v.y(); mVect[2] += v.z();
+            return *this;
+        };
+
+        /**
+         * Vector substraction in place
+         * @param v The second vector
+         * @return The vector
+        */
+        Vector3 & operator -= (const Vector3 & v){
+            mVect[0] -= v.x(); mVect[1] -= v.y(); mVect[2] -= v.z();
+            return *this;
+        };
+
+        /**
+         * Vector scalar multiplication in place
+         * @param f The constant
+         * @return The vector
+        */
+        Vector3 & operator *= (const float & f){
+            mVect[0] *= f; mVect[1] *= f; mVect[2] *= f;
+            return *this;
+        };
+
+        /**
+         * Vector scalar division in place
+         * @param f The constant
+         * @return The vector
+        */
+        Vector3 & operator /= (const float & f){
+            mVect[0] /= f; mVect[1] /= f; mVect[2] /= f;
+            return *this;
         };
 
         /**
@@ -214,14 +256,14 @@ class Vector3{
 	    
         /**
          * Normalized a vector
-         * @return A new vector corresponding to the normalised vector
+         * @return The normalised vector
         */
         Vector3 normalize() const { 
             float n = norm();  
             float newX = x()/n; 
             float newY = y()/n; 
             float newZ = z()/n;
-            return * new Vector3(newX,newY,newZ);
+            return Vector3(newX,newY,newZ);
         }
 
         /**
@@ -241,7 +283,7 @@ class Vector3{
          * @return The cross product of v1 and v2 as a new vector
         */
         static Vector3 cross(const Vector3 & v1, const Vector3 & v2){
-            return * new Vector3(
+            return Vector3(
                                     v1.y()*v2.z() - v1.z()*v2.y(),
                                     v1.z()*v2.x() - v1.x()*v2.z(),
                                     v1.x()*v2.y() - v1.y()*v2.x()
@@ -289,14 +331,12 @@ class Vector3{
          * @param p3 The third point
          * @return The normal as a vector
         */
-        static maths::Vector3* getNormalOfPlane(const Vector3 & p1, const Vector3 & p2, const Vector3 & p3){
+        static maths::Vector3 getNormalOfPlane(const Vector3 & p1, const Vector3 & p2, const Vector3 & p3){
             // get two vectors of the plane
             Vector3 v1 = p3 - p1;
             Vector3 v2 = p2 - p1;
 
-            Vector3 normal = cross(v1, v2).normalize();
-
-            return new Vector3(normal);
+            return cross(v1, v2).normalize();
         }
 };
 
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cmath>
+
+#include "glm/glm.hpp"
+#include "vector3.hpp"
+
+namespace maths{
+
+/**
+ * Kernels working on arrays of vectors for the hot loops of the meshes
+ * The loops are branch free over contiguous aligned vectors so the compiler can vectorize them
+*/
+class Vector3Batch{
+
+    public:
+        /**
+         * Get the sum of the absolute cosines between the consecutive edges of a polygon
+         * @param polygon The corners of the polygon
+         * @param n The number of corners
+         * @return The sum, 0 for a polygon with right angles
+        */
+        static float sumCornerCosines(const Vector3* polygon, int n){
+            float sum = 0.0f;
+            // every edge is normalized once and used by its two corners
+            Vector3 first = (polygon[1 % n] - polygon[0]).normalize();
+            Vector3 prev = first;
+            for (int i = 1; i < n; i++){
+                Vector3 cur = (polygon[(i+1) % n] - polygon[i]).normalize();
+                sum += std::abs(Vector3::dot(prev, cur));
+                prev = cur;
+            }
+            return sum + std::abs(Vector3::dot(prev, first));
+        }
+
+        /**
+         * Get the sums of sumCornerCosines for many quads at once, with the same operations so the results are equal
+         * @param corners The quads' corners by component, 12 rows of n floats: the x, y and z of the first corners, then of the second ones...
+         * @param n The number of quads
+         * @param sums Receives the sum of each quad
+        */
+        static void sumQuadCornerCosines(const float* __restrict corners, int n, float* __restrict sums){
+            const float* x0 = corners;       const float* y0 = corners + n;    const float* z0 = corners + 2*n;
+            const float* x1 = corners + 3*n; const float* y1 = corners + 4*n;  const float* z1 = corners + 5*n;
+            const float* x2 = corners + 6*n; const float* y2 = corners + 7*n;  const float* z2 = corners + 8*n;
+            const float* x3 = corners + 9*n; const float* y3 = corners + 10*n; const float* z3 = corners + 11*n;
+            // one quad per lane, the four edges stay in registers
+            for (int i = 0; i < n; i++){
+                float e0x, e0y, e0z, e1x, e1y, e1z, e2x, e2y, e2z, e3x, e3y, e3z;
+                edgeDirection(x0[i], y0[i], z0[i], x1[i], y1[i], z1[i], e0x, e0y, e0z);
+                edgeDirection(x1[i], y1[i], z1[i], x2[i], y2[i], z2[i], e1x, e1y, e1z);
+                edgeDirection(x2[i], y2[i], z2[i], x3[i], y3[i], z3[i], e2x, e2y, e2z);
+                edgeDirection(x3[i], y3[i], z3[i], x0[i], y0[i], z0[i], e3x, e3y, e3z);
+                float sum = std::abs(e0x*e1x + e0y*e1y + e0z*e1z);
+                sum += std::abs(e1x*e2x + e1y*e2y + e1z*e2z);
+                sum += std::abs(e2x*e3x + e2y*e3y + e2z*e3z);
+                sums[i] = sum + std::abs(e3x*e0x + e3y*e0y + e3z*e0z);
+            }
+        }
+
+        /**
+         * Count the vectors with a positive dot product with a given vector
+         * @param v The given vector
+         * @param vectors The vectors
+         * @param n The number of vectors
+         * @return The number of positive dot products
+        */
+        static int countPositiveDots(const Vector3 & v, const Vector3* vectors, int n){
+            int nb = 0;
+            for (int i = 0; i < n; i++) nb += Vector3::dot(vectors[i], v) > 0.0f;
+            return nb;
+        }
+
+        /**
+         * Fit a plane z = a*x + b*y + c in points with ordinary least squares
+         * @param points The points
+         * @param n The number of points
+         * @return The plane a, b and c values in a vector
+        */
+        static Vector3 fitPlane(const Vector3* points, int n){
+            float sumX = 0.0f; float sumY = 0.0f; float sumZ = 0.0f;
+            float sumXY = 0.0f; float sumXZ = 0.0f; float sumYZ = 0.0f;
+            float sumXX = 0.0f; float sumYY = 0.0f;
+
+            for (int i = 0; i < n; i++){
+                float x = points[i].x(); float y = points[i].y(); float z = points[i].z();
+                sumX += x; sumY += y; sumZ += z;
+                sumXX += x*x; sumYY += y*y;
+                sumXY += x*z; sumYZ += y*z;
+            }
+            glm::mat3 matA = {
+                sumXX, sumXY, sumX,
+                sumXY, sumYY, sumY,
+                sumX, sumY, float(n)
+            };
+            glm::vec3 vecB = {sumXZ, sumYZ, sumZ};
+
+            glm::vec3 planeCoeffs = glm::inverse(matA)*vecB;
+            return Vector3(planeCoeffs.x, planeCoeffs.y, planeCoeffs.z);
+        }
+
+        /**
+         * Get the root of the sum of the squared vertical distances between points and a plane z = a*x + b*y + c
+         * @param points The points
+         * @param n The number of points
+         * @param a The plane's a value
+         * @param b The plane's b value
+         * @param c The plane's c value
+         * @return The root of the sum of the squared distances
+        */
+        static float verticalDistance(const Vector3* points, int n, float a, float b, float c){
+            float sum = 0.0f;
+            for (int i = 0; i < n; i++){
+                float realZ = points[i].z();
+                float estiZ = a*points[i].x() + b*points[i].y() + c;
+                sum += (realZ-estiZ) * (realZ-estiZ);
+            }
+            return sqrtf(sum);
+        }
+
+    private:
+        /**
+         * Get the normalized vector between two points like Vector3::normalize, without the vectors' type checks so the batched loops stay branch free
+         * @param x0, y0, z0 The first point
+         * @param x1, y1, z1 The second point
+         * @param x, y, z Receive the direction from the first point to the second
+        */
+        static void edgeDirection(float x0, float y0, float z0, float x1, float y1, float z1, float & x, float & y, float & z){
+            x = x1 - x0; y = y1 - y0; z = z1 - z0;
+            float norm = sqrtf(x*x + y*y + z*z);
+            x /= norm; y /= norm; z /= norm;
+        }
+};
+
+}
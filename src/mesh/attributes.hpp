@@ -0,0 +1,252 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mesh{
+
+/**
+ * The untyped part of an attribute channel, so the mesh can keep every channel in line with its list
+*/
+class AttributeChannelBase{
+
+    public:
+        virtual ~AttributeChannelBase(){}
+
+        /**
+         * Set the number of values, the new ones get the default value
+         * @param size The number of values
+        */
+        virtual void resize(size_t size) = 0;
+
+        /**
+         * Move the last value into a slot, like the removal of an element from its list
+         * @param slot The slot of the removed element
+        */
+        virtual void removeSlot(int slot) = 0;
+
+        /**
+         * Move the values of the kept elements to their new slots after a compaction of the list
+         * @param map The new slot of each old slot, -1 for the removed elements
+         * @param size The number of kept elements
+        */
+        virtual void compact(const std::vector<int> & map, size_t size) = 0;
+
+        /**
+         * Copy the channel in a new order
+         * @param order The old slot of each new slot
+         * @return The new channel
+        */
+        virtual std::unique_ptr<AttributeChannelBase> copyInOrder(const std::vector<int> & order) const = 0;
+};
+
+/**
+ * The values of an attribute for all the elements of a kind, stored contiguously and indexed by the elements' slots
+*/
+template<typename T>
+class AttributeChannel : public AttributeChannelBase{
+
+    // std::vector<bool> packs its values and can't give references to them
+    static_assert(!std::is_same<T, bool>::value, "Use char channels for flags");
+
+    public:
+        /**
+         * A basic constructor
+         * @param size The number of values
+         * @param defaultValue The value of the elements not set yet
+        */
+        AttributeChannel(size_t size, const T & defaultValue) : mValues(size, defaultValue), mDefault(defaultValue){}
+
+        T & operator[](int slot){
+            return mValues[slot];
+        }
+
+        const T & operator[](int slot) const{
+            return mValues[slot];
+        }
+
+        /**
+         * Get the values, to read or write them all at once
+         * @return The first value
+        */
+        T* data(){
+            return mValues.data();
+        }
+
+        const T* data() const{
+            return mValues.data();
+        }
+
+        size_t size() const{
+            return mValues.size();
+        }
+
+        void resize(size_t size) override{
+            mValues.resize(size, mDefault);
+        }
+
+        void removeSlot(int slot) override{
+            if(slot != int(mValues.size())-1) mValues[slot] = std::move(mValues.back());
+            mValues.pop_back();
+        }
+
+        void compact(const std::vector<int> & map, size_t size) override{
+            // the kept values only move towards the front
+            for(int i=0; i<int(map.size()); i++){
+                if(map[i] >= 0 && map[i] != i) mValues[map[i]] = std::move(mValues[i]);
+            }
+            mValues.resize(size, mDefault);
+        }
+
+        std::unique_ptr<AttributeChannelBase> copyInOrder(const std::vector<int> & order) const override{
+            std::unique_ptr<AttributeChannel<T>> copy(new AttributeChannel<T>(0, mDefault));
+            copy->mValues.reserve(order.size());
+            for(int i : order) copy->mValues.push_back(mValues[i]);
+            return copy;
+        }
+
+    private:
+        std::vector<T> mValues;
+        T mDefault;
+};
+
+/**
+ * The attribute channels of one kind of element, found by their names
+ * Every channel has one value per element of the list, so the passes only go through the channels they need
+*/
+class AttributeSet{
+
+    public:
+        AttributeSet(){}
+
+        AttributeSet(const AttributeSet &) = delete;
+        AttributeSet & operator=(const AttributeSet &) = delete;
+        AttributeSet(AttributeSet &&) = default;
+        AttributeSet & operator=(AttributeSet &&) = default;
+
+        /**
+         * Attach a channel, or get it if it is already attached
+         * @param name The name of the channel
+         * @param defaultValue The value of the elements not set yet
+         * @exception Invalid_Argument if a channel of another type has this name
+         * @return The channel
+        */
+        template<typename T>
+        mesh::AttributeChannel<T> & attach(const std::string & name, const T & defaultValue = T()){
+            std::unique_ptr<AttributeChannelBase> & channel = mChannels[name];
+            if(!channel) channel.reset(new AttributeChannel<T>(mSize, defaultValue));
+            mesh::AttributeChannel<T>* typed = dynamic_cast<mesh::AttributeChannel<T>*>(channel.get());
+            if(!typed){
+                std::fprintf(stderr, "Error, the attribute %s is already attached with another type!\n", name.c_str());
+                throw std::invalid_argument("Need the type of the attached attribute!\n");
+            }
+            return *typed;
+        }
+
+        /**
+         * Detach a channel and free its values, nothing happens if it is not attached
+         * @param name The name of the channel
+        */
+        void detach(const std::string & name){
+            mChannels.erase(name);
+        }
+
+        /**
+         * Check if a channel is attached
+         * @param name The name of the channel
+         * @return True if it is
+        */
+        bool has(const std::string & name) const{
+            return mChannels.count(name) > 0;
+        }
+
+        /**
+         * Get an attached channel
+         * @param name The name of the channel
+         * @return The channel, nullptr if it is not attached or has another type
+        */
+        template<typename T>
+        mesh::AttributeChannel<T>* find(const std::string & name){
+            auto channel = mChannels.find(name);
+            if(channel == mChannels.end()) return nullptr;
+            return dynamic_cast<mesh::AttributeChannel<T>*>(channel->second.get());
+        }
+
+        template<typename T>
+        const mesh::AttributeChannel<T>* find(const std::string & name) const{
+            auto channel = mChannels.find(name);
+            if(channel == mChannels.end()) return nullptr;
+            return dynamic_cast<const mesh::AttributeChannel<T>*>(channel->second.get());
+        }
+
+        /**
+         * Get the names of the attached channels
+         * @return The names in alphabetical order
+        */
+        std::vector<std::string> names() const{
+            std::vector<std::string> res;
+            for(const auto & channel : mChannels) res.push_back(channel.first);
+            return res;
+        }
+
+        /**
+         * Get the number of values of every channel
+         * @return The number of elements
+        */
+        size_t size() const{
+            return mSize;
+        }
+
+        /**
+         * Set the number of values of every channel, the new ones get their default value
+         * @param size The number of elements
+        */
+        void resize(size_t size){
+            mSize = size;
+            for(auto & channel : mChannels) channel.second->resize(size);
+        }
+
+        /**
+         * Move the last values into a slot in every channel, like the removal of an element from its list
+         * @param slot The slot of the removed element
+        */
+        void removeSlot(int slot){
+            mSize--;
+            for(auto & channel : mChannels) channel.second->removeSlot(slot);
+        }
+
+        /**
+         * Move the values of the kept elements to their new slots in every channel
+         * @param map The new slot of each old slot, -1 for the removed elements
+         * @param size The number of kept elements
+        */
+        void compact(const std::vector<int> & map, size_t size){
+            mSize = size;
+            for(auto & channel : mChannels) channel.second->compact(map, size);
+        }
+
+        /**
+         * Copy every channel in a new order
+         * @param order The old slot of each new slot
+         * @return The new set
+        */
+        AttributeSet copyInOrder(const std::vector<int> & order) const{
+            AttributeSet copy;
+            copy.mSize = order.size();
+            for(const auto & channel : mChannels) copy.mChannels[channel.first] = channel.second->copyInOrder(order);
+            return copy;
+        }
+
+    private:
+        std::map<std::string, std::unique_ptr<AttributeChannelBase>> mChannels;
+        size_t mSize = 0;
+};
+
+}
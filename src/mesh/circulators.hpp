@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+
+#include "edge.hpp"
+#include "face.hpp"
+#include "vertex.hpp"
+
+namespace mesh{
+
+/**
+ * A range going once around a ring of edges without allocating, usable in range-for loops
+ * The step gives the next edge of the ring and the element seen from an edge
+*/
+template<typename Step>
+class Circulator{
+
+    public:
+        using value_type = decltype(Step::get(static_cast<mesh::Edge*>(nullptr)));
+
+        class iterator{
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = Circulator::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = value_type;
+
+                iterator(mesh::Edge* edge, mesh::Edge* start, bool lap) : mEdge(edge), mStart(start), mLap(lap){}
+
+                value_type operator * () const{
+                    return Step::get(mEdge);
+                }
+
+                /**
+                 * The current edge of the ring
+                */
+                mesh::Edge* edge() const{
+                    return mEdge;
+                }
+
+                iterator & operator ++ (){
+                    mEdge = Step::next(mEdge);
+                    assert(mEdge != nullptr);
+                    if (mEdge == mStart) mLap = true;
+                    return *this;
+                }
+
+                iterator operator ++ (int){
+                    iterator it = *this;
+                    ++(*this);
+                    return it;
+                }
+
+                bool operator == (const iterator & it) const{
+                    return mEdge == it.mEdge && mLap == it.mLap;
+                }
+
+                bool operator != (const iterator & it) const{
+                    return !(*this == it);
+                }
+
+            private:
+                mesh::Edge* mEdge;
+                mesh::Edge* mStart;
+                bool mLap;
+        };
+
+        /**
+         * A basic constructor
+         * @param start The first edge of the ring
+        */
+        explicit Circulator(mesh::Edge* start) : mStart(start){}
+
+        iterator begin() const{
+            return iterator(mStart, mStart, false);
+        }
+
+        iterator end() const{
+            return iterator(mStart, mStart, true);
+        }
+
+        /**
+         * Count the elements of the ring
+         * @return The number of elements
+        */
+        int size() const{
+            int nb = 0;
+            for (iterator it = begin(); it != end(); ++it) nb++;
+            return nb;
+        }
+
+    private:
+        mesh::Edge* mStart;
+};
+
+/**
+ * Turn around a face through the right clock wise edges
+*/
+struct FaceEdgeStep{
+    static mesh::Edge* next(mesh::Edge* edge){ assert(edge->mEdgeRightCW->mFaceRight == edge->mFaceRight); return edge->mEdgeRightCW; }
+    static mesh::Edge* get(mesh::Edge* edge){ return edge; }
+};
+
+/**
+ * Turn around a face and see the origins of the edges
+*/
+struct FaceVertexStep{
+    static mesh::Edge* next(mesh::Edge* edge){ return mesh::FaceEdgeStep::next(edge); }
+    static mesh::Vertex* get(mesh::Edge* edge){ return edge->mVertexOrigin; }
+};
+
+/**
+ * Turn around a vertex through its outgoing edges
+*/
+struct VertexEdgeStep{
+    static mesh::Edge* next(mesh::Edge* edge){
+        mesh::Edge* nextEdge = edge->mEdgeRightCCW->mReverseEdge;
+        assert(nextEdge->mVertexOrigin == edge->mVertexOrigin);
+        return nextEdge;
+    }
+    static mesh::Edge* get(mesh::Edge* edge){ return edge; }
+};
+
+/**
+ * Turn around a vertex and see the faces on the right of its outgoing edges
+*/
+struct VertexFaceStep{
+    static mesh::Edge* next(mesh::Edge* edge){ return mesh::VertexEdgeStep::next(edge); }
+    static mesh::Face* get(mesh::Edge* edge){ return edge->mFaceRight; }
+};
+
+/**
+ * Get the edges around a face, the face being on their right
+ * @param face The face
+ * @return The edges, starting with the face's edge
+*/
+inline mesh::Circulator<mesh::FaceEdgeStep> faceEdges(const mesh::Face* face){
+    return mesh::Circulator<mesh::FaceEdgeStep>(face->mEdge);
+}
+
+/**
+ * Get the vertices around a face, a vertex appears twice if the face is a doublet
+ * @param face The face
+ * @return The vertices, starting with the origin of the face's edge
+*/
+inline mesh::Circulator<mesh::FaceVertexStep> faceVertices(const mesh::Face* face){
+    return mesh::Circulator<mesh::FaceVertexStep>(face->mEdge);
+}
+
+/**
+ * Gather the distinct vertices around a face like Face::getSurroundingVertices, without allocating
+ * @param face The face
+ * @param vertices The array receiving the vertices
+ * @param max The size of the array
+ * @return The number of distinct vertices, max+1 if there are more than max
+*/
+inline int gatherFaceVertices(const mesh::Face* face, mesh::Vertex** vertices, int max){
+    int nb = 0;
+    for (mesh::Vertex* v : mesh::faceVertices(face)){
+        bool canInsert = true;
+        for (int i = 0; i < nb && canInsert; i++) canInsert = vertices[i] != v;
+        if (!canInsert) continue;
+        if (nb == max) return max + 1;
+        vertices[nb++] = v;
+    }
+    return nb;
+}
+
+/**
+ * Get the first edge going out of a vertex
+ * @param vertex The vertex
+ * @return The outgoing edge
+*/
+inline mesh::Edge* outgoingEdge(const mesh::Vertex* vertex){
+    return vertex->mEdge->mVertexOrigin == vertex ? vertex->mEdge : vertex->mEdge->mReverseEdge;
+}
+
+/**
+ * Get the edges going out of a vertex
+ * @param vertex The vertex
+ * @return The outgoing edges in the order of Vertex::getSurroundingEdges, their reversed edges being the incoming ones
+*/
+inline mesh::Circulator<mesh::VertexEdgeStep> vertexEdges(const mesh::Vertex* vertex){
+    return mesh::Circulator<mesh::VertexEdgeStep>(mesh::VertexEdgeStep::next(mesh::outgoingEdge(vertex)));
+}
+
+/**
+ * Get the faces around a vertex
+ * @param vertex The vertex
+ * @return The faces in the order of Vertex::getSurroundingFaces
+*/
+inline mesh::Circulator<mesh::VertexFaceStep> vertexFaces(const mesh::Vertex* vertex){
+    return mesh::Circulator<mesh::VertexFaceStep>(mesh::VertexFaceStep::next(mesh::outgoingEdge(vertex)));
+}
+
+}
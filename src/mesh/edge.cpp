@@ -1,25 +1,19 @@
 #include "edge.hpp"
 #include "vector3.hpp"
+#include "vector3Batch.hpp"
 #include <stdexcept>
 #include <cassert>
 
-int mesh::Edge::ID_CPT = 0;
 
 bool mesh::Edge::isRemovable(){
     return (!this->mFaceLeft->mToMerge) && (!this->mFaceRight->mToMerge); 
 }
 
-float mesh::Edge::getSumPairwiseDotProd(std::vector<mesh::Vertex*> vertexList){
-    float sum = 0;
-    int len = int(vertexList.size());
-
-    for(int i=0; i<len; i++){
-        maths::Vector3 v1 = (vertexList[(i+1)%len]->mCoords - vertexList[i]->mCoords);
-        maths::Vector3 v2 = (vertexList[(i+2)%len]->mCoords - vertexList[(i+1)%len]->mCoords);
-        sum += std::abs(maths::Vector3::dot(v1.normalize(), v2.normalize()));
-    }
-
-    return sum;
+float mesh::Edge::getSumPairwiseDotProd(const std::vector<mesh::Vertex*> & vertexList){
+    std::vector<maths::Vector3> corners;
+    corners.reserve(vertexList.size());
+    for(int i=0; i<int(vertexList.size()); i++) corners.push_back(vertexList[i]->mCoords);
+    return maths::Vector3Batch::sumCornerCosines(corners.data(), int(corners.size()));
 }
 
 float mesh::Edge::getPerimeter(std::vector<mesh::Edge*> edgeList){
@@ -108,11 +102,6 @@ void mesh::Edge::createReversed(mesh::Edge* edge){
     edge->mEdgeLeftCW = mEdgeRightCW->mReverseEdge;
 }
 
-
-bool mesh::Edge::cmp(const mesh::Edge &e1, const mesh::Edge &e2){
-    return e1.mSumDotProd < e2.mSumDotProd;
-}
-
 bool mesh::Edge::hasDoubles(std::vector<mesh::Edge*> edges){
     int nbEdges = int(edges.size());
     for(int i=0; i<nbEdges; i++){
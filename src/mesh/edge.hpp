@@ -18,12 +18,6 @@ enum EdgePos {LCW, LCCW, RCW, RCCW, NONE};
 */
 class Edge{
 
-    public:
-        /**
-         * The id counter
-        */
-        static int ID_CPT;
-
     public:
         /**
          * First vertex of the edge
@@ -76,14 +70,14 @@ class Edge{
         bool mToDelete = false;
 
         /**
-         * The edge's id
+         * The edge's id, unique in its mesh, -1 until the mesh creates it
         */
-        int mId = (mesh::Edge::ID_CPT++);
+        int mId = -1;
 
         /**
-         * The sum of pariwised dot product
+         * The edge's index in its mesh's list, -1 when it is in none
         */
-        float mSumDotProd;
+        int mSlot = -1;
 
 
     public:
@@ -147,7 +141,7 @@ class Edge{
          * @param vertexList A list of vertices surrounding a face 
          * @return The sum of the dot products
         */
-        static float getSumPairwiseDotProd(std::vector<mesh::Vertex*> vertexList);
+        static float getSumPairwiseDotProd(const std::vector<mesh::Vertex*> & vertexList);
 
         /**
          * Get the perimeter of edges surrounding a face
@@ -198,14 +192,6 @@ class Edge{
         */
         void createReversed(mesh::Edge* edge);
 
-        /**
-         * Compare two edges in term of their pairwised dot product sum
-         * @param e1 The first edge
-         * @param e2 The second edge
-         * @return True if the first edge is lesser than the second one
-        */
-        static bool cmp(const mesh::Edge &e1, const mesh::Edge &e2);
-
         /**
          * Merge two edges
          * @param e2 The second edge
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace mesh{
+
+/**
+ * The memory usage of a pool
+*/
+struct PoolStats{
+    size_t size;
+    size_t highWater;
+    size_t capacity;
+    size_t bytes;
+};
+
+/**
+ * A pool storing the elements of a mesh contiguously in large blocks
+ * The elements never move once created, so they can still be linked by pointers,
+ * the slots of the destroyed elements are reused by the next ones
+ * and the remaining elements are destroyed with the pool
+*/
+template<typename T>
+class ElementPool{
+
+    public:
+        ElementPool(){}
+
+        ElementPool(const ElementPool &) = delete;
+        ElementPool & operator=(const ElementPool &) = delete;
+
+        /**
+         * The destructor, destroy every element created in the pool
+        */
+        ~ElementPool(){
+            std::sort(mFree.begin(), mFree.end());
+            for (Block & block : mBlocks){
+                for (size_t i = 0; i < block.size; i++){
+                    if (!std::binary_search(mFree.begin(), mFree.end(), block.data + i)) block.data[i].~T();
+                }
+                ::operator delete(static_cast<void*>(block.data));
+            }
+        }
+
+        /**
+         * Make sure the next elements are created one after the other in the same block
+         * once the free slots are used
+         * @param nb The number of elements
+        */
+        void reserve(size_t nb){
+            if (nb > 0 && (mBlocks.empty() || mBlocks.back().capacity - mBlocks.back().size < nb)) addBlock(nb);
+        }
+
+        /**
+         * Create an element in the last freed slot or at the end of the pool
+         * @param args The arguments of the element's constructor
+         * @return The new element
+        */
+        template<typename... Args>
+        T* create(Args &&... args){
+            T* element;
+            if (!mFree.empty()){
+                element = new (mFree.back()) T(std::forward<Args>(args)...);
+                mFree.pop_back();
+            }
+            else{
+                if (mBlocks.empty() || mBlocks.back().size == mBlocks.back().capacity) addBlock(BLOCK_SIZE);
+                Block & block = mBlocks.back();
+                element = new (block.data + block.size) T(std::forward<Args>(args)...);
+                block.size++;
+            }
+            mSize++;
+            mHighWater = std::max(mHighWater, mSize);
+            return element;
+        }
+
+        /**
+         * Destroy an element of the pool, its slot is reused by the next creation
+         * @param element The element, which must not be used anymore
+        */
+        void destroy(T* element){
+            element->~T();
+            mFree.push_back(element);
+            mSize--;
+        }
+
+        /**
+         * Get the number of elements alive in the pool
+         * @return The number of elements
+        */
+        size_t size() const{
+            return mSize;
+        }
+
+        /**
+         * Get the memory usage of the pool
+         * @return The number of elements alive, the most ever alive at once and the allocated slots and bytes
+        */
+        mesh::PoolStats stats() const{
+            size_t capacity = 0;
+            for (const Block & block : mBlocks) capacity += block.capacity;
+            return {mSize, mHighWater, capacity, capacity*sizeof(T) + mFree.capacity()*sizeof(T*)};
+        }
+
+    private:
+        /**
+         * The number of elements of a block when none was reserved
+        */
+        static constexpr size_t BLOCK_SIZE = 4096;
+
+        /**
+         * A block of elements, the first size ones have been constructed
+        */
+        struct Block{
+            T* data;
+            size_t size;
+            size_t capacity;
+        };
+
+        void addBlock(size_t capacity){
+            mBlocks.push_back({static_cast<T*>(::operator new(capacity*sizeof(T))), 0, capacity});
+        }
+
+        std::vector<Block> mBlocks;
+        std::vector<T*> mFree;
+        size_t mSize = 0;
+        size_t mHighWater = 0;
+};
+
+}
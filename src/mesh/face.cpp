@@ -1,9 +1,9 @@
 #include "face.hpp"
 #include "edge.hpp"
+#include "circulators.hpp"
 #include <vector>
 #include <cassert>
 
-int mesh::Face::ID_CPT = 0;
 
 std::vector<mesh::Edge*> mesh::Face::getSurroundingEdges(mesh::Edge* startingEdge) const{
     std::vector<mesh::Edge*> surEdges;
@@ -66,19 +66,17 @@ std::vector<mesh::Vertex*> mesh::Face::getSurroundingVertices() const{
 
 std::vector<mesh::Face*> mesh::Face::getSurroundingFaces() const{
     std::vector<mesh::Face*> surFaces;
-    std::vector<mesh::Edge*>surEdges = getSurroundingEdges(mEdge);
-    // print();
-    for(int i=0; i<int(surEdges.size()); i++){
-        if(surEdges[i]->mFaceLeft->mId != mId){
+    for(mesh::Edge* curEdge : mesh::faceEdges(this)){
+        if(curEdge->mFaceLeft->mId != mId){
             bool alreadyAdded = false;
             for(int j=0; j<int(surFaces.size()); j++){
-                if(surFaces[j]->mId == surEdges[i]->mFaceLeft->mId){
+                if(surFaces[j]->mId == curEdge->mFaceLeft->mId){
                     alreadyAdded = true;
                     break;
                 }
             }
             if(!alreadyAdded)
-                surFaces.push_back(surEdges[i]->mFaceLeft);
+                surFaces.push_back(curEdge->mFaceLeft);
         }
     }
     return surFaces;
@@ -86,23 +84,20 @@ std::vector<mesh::Face*> mesh::Face::getSurroundingFaces() const{
 
 
 std::vector<mesh::Face*> mesh::Face::getAllSurroundingFaces() const{
-    std::vector<mesh::Vertex*> surVertices = getSurroundingVertices();
     std::vector<mesh::Face*> surFaces;
-    // print();
-    for(int i=0; i<int(surVertices.size()); i++){
-        std::vector<mesh::Face*> surFacesTmp = surVertices[i]->getSurroundingFaces();
-        for(int j=0; j<int(surFacesTmp.size()); j++){
-            if(surFacesTmp[j]->mId != mId){
+    // a vertex seen twice brings no new face
+    for(mesh::Vertex* curVertex : mesh::faceVertices(this)){
+        for(mesh::Face* curFace : mesh::vertexFaces(curVertex)){
+            if(curFace->mId != mId){
                 bool alreadyAdded = false;
                 for(int k=0; k<int(surFaces.size()); k++){
-                    if(surFaces[k]->mId == surFacesTmp[j]->mId){
+                    if(surFaces[k]->mId == curFace->mId){
                         alreadyAdded = true;
                         break;
                     }
                 }
                 if(!alreadyAdded) {
-                    // surFacesTmp[j]->print();
-                    surFaces.push_back(surFacesTmp[j]);
+                    surFaces.push_back(curFace);
                 }
             }
         }
@@ -262,10 +257,12 @@ std::vector<mesh::Vertex*> mesh::Face::getUnconnectedVertices(mesh::Face* f2) co
     return unconnected; 
 }
 
-void mesh::Face::createDiagonal(){
+void mesh::Face::createDiagonal(mesh::ElementPool<mesh::Diagonal> & diagonals){
     assert(!mToDelete);
-    std::vector<mesh::Vertex*> surVertices = getSurroundingVertices();
-    assert(surVertices.size() == 4); // only on quads
+    mesh::Vertex* surVertices[4];
+    int nbSurVertices = mesh::gatherFaceVertices(this, surVertices, 4);
+    assert(nbSurVertices == 4); // only on quads
+    (void)nbSurVertices;
 
     float minDiag = INFINITY;
     mesh::Vertex* v1 = nullptr;
@@ -294,7 +291,7 @@ void mesh::Face::createDiagonal(){
 
     if(v1 && v2){
         if(mDiagonal == nullptr){ // init the diagonal
-            mesh::Diagonal* diag = new mesh::Diagonal();
+            mesh::Diagonal* diag = diagonals.create();
             diag->face = this;
             diag->v1 = v1;
             diag->v2 = v2;
@@ -308,20 +305,27 @@ void mesh::Face::createDiagonal(){
     } else mDiagonal = nullptr;
 }
 
-mesh::Diagonal* mesh::Face::cmpDiagonal(mesh::Diagonal* d1, mesh::Diagonal* d2){
-    float priorityD1 = d1->length * d1->face->mSFitmap;
-    float priorityD2 = d2->length * d2->face->mSFitmap;
+bool mesh::DiagonalEntry::isCurrent() const{
+    const mesh::Face* face = diagonal->face;
+    return face->mId == faceId && !face->mToDelete && face->mDiagonal == diagonal && diagonal->priority == priority;
+}
 
-    if(priorityD1 < priorityD2) return d1;
-    return d2;
+bool mesh::Face::cmpDiagonal(const mesh::DiagonalEntry & d1, const mesh::DiagonalEntry & d2){
+    // the std heaps keep their greatest element at the front, so the shortest diagonal compares greatest
+    if(d1.priority != d2.priority) return d1.priority > d2.priority;
+    return d1.faceId > d2.faceId;
 }
 
 
-std::vector<mesh::Diagonal*> mesh::Face::getMinHeap(std::vector<mesh::Face*> faces){
+std::vector<mesh::DiagonalEntry> mesh::Face::getMinHeap(std::vector<mesh::Face*> faces){
     // get all the diagonals
-    std::vector<mesh::Diagonal*> diags;
+    std::vector<mesh::DiagonalEntry> diags;
     for(int i=0; i<int(faces.size()); i++) {
-        if(faces[i]->mDiagonal && !faces[i]->mToDelete) diags.push_back(faces[i]->mDiagonal);
+        mesh::Diagonal* diag = faces[i]->mDiagonal;
+        if(diag && !faces[i]->mToDelete){
+            diag->priority = diag->weightedLength();
+            diags.push_back({diag->priority, faces[i]->mId, diag});
+        }
     }
     std::make_heap(diags.begin(), diags.end(), mesh::Face::cmpDiagonal);
     return diags;
@@ -330,9 +334,7 @@ std::vector<mesh::Diagonal*> mesh::Face::getMinHeap(std::vector<mesh::Face*> fac
 std::vector<mesh::Edge*> mesh::Face::isDoublet() const{
     std::vector<mesh::Edge*> res;
 
-    std::vector<mesh::Edge*> surEdges = getSurroundingEdges(mEdge);
-    for(int i=0; i<int(surEdges.size()); i++){
-        mesh::Edge* curEdge = surEdges[i];
+    for(mesh::Edge* curEdge : mesh::faceEdges(this)){
         if(!curEdge->check()){
             if(!curEdge->mEdgeRightCW->check()){
                 // printf("cur edge:\n"); curEdge->print();
@@ -355,7 +357,8 @@ std::vector<mesh::Edge*> mesh::Face::isDoublet() const{
 }
 
 bool mesh::Face::isSinglet() const{
-    return (getSurroundingVertices().size() == 3);
+    mesh::Vertex* surVertices[3];
+    return mesh::gatherFaceVertices(this, surVertices, 3) == 3;
 }
 
 void mesh::Face::markToUpdate(std::vector<mesh::Face*> faces){
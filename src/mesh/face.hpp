@@ -3,6 +3,7 @@
 #include "edge.hpp"
 #include "vertex.hpp"
 #include "maths.hpp"
+#include "elementPool.hpp"
 
 #include <vector>
 #include <algorithm>
@@ -38,6 +39,52 @@ struct Diagonal{
      * The length of the diagonal
     */
     float length;
+
+    /**
+     * The weight of the length in the collapse priority, the face's S fitmap
+    */
+    float weight = 1.0f;
+
+    /**
+     * The weighted length of the diagonal's latest entry in the heap, its older entries are stale
+    */
+    float priority = 0.0f;
+
+    /**
+     * Get the collapse priority of the diagonal, the shortest weighted diagonals are collapsed first
+     * @return The length times the weight, infinite for a degenerated diagonal
+    */
+    float weightedLength() const{
+        float res = length * weight;
+        return std::isnan(res) ? INFINITY : res;
+    }
+};
+
+/**
+ * A structure to represent an entry of the diagonal heap, a snapshot of a diagonal when it was pushed
+ * A diagonal gets a new entry each time its priority changes, the entries not matching it anymore are skipped
+*/
+struct DiagonalEntry{
+    /**
+     * The weighted length of the diagonal when it was pushed
+    */
+    float priority;
+
+    /**
+     * The id of the diagonal's face, which breaks the ties between the priorities
+    */
+    int faceId;
+
+    /**
+     * The diagonal
+    */
+    mesh::Diagonal* diagonal;
+
+    /**
+     * Tell if the entry still matches its diagonal
+     * @return False if the face was removed, dropped the diagonal or if the diagonal was pushed again since
+    */
+    bool isCurrent() const;
 };
 
 /**
@@ -45,12 +92,6 @@ struct Diagonal{
 */
 class Face{
 
-    public:
-        /**
-         * The id counter
-        */
-        static int ID_CPT;
-
     public:
         /**
          *  One of the surronding edge
@@ -68,9 +109,14 @@ class Face{
         bool mToMerge = false;
 
         /**
-         * The face's id
+         * The face's id, unique in its mesh, -1 until the mesh creates it
         */
-        int mId = (mesh::Face::ID_CPT++);
+        int mId = -1;
+
+        /**
+         * The face's index in its mesh's list, -1 when it is in none
+        */
+        int mSlot = -1;
 
         /**
          * Flag to know it the face is a triangle
@@ -87,21 +133,6 @@ class Face{
         */
         bool mToUpdate = false;
 
-        /**
-         * The face normal
-        */
-        maths::Vector3* mNormal;
-
-        /**
-         * The S fitmap
-        */
-        float mSFitmap = 0.0f;
-        
-        /**
-         * The M fitmap
-        */ 
-        float mMFitmap = 0.0f;
-
     public:
         /**
          * A basic constructor
@@ -208,23 +239,26 @@ class Face{
 
         /**
          * Set the diagonal as the shortest diagonal of a face
+         * A face which is not a quad anymore drops its diagonal without destroying it, the heap may still point at it
+         * @param diagonals The pool of the mesh's diagonals, where a face without diagonal creates one
         */
-        void createDiagonal();
+        void createDiagonal(mesh::ElementPool<mesh::Diagonal> & diagonals);
 
         /**
-         * Get a min heap according to the diagonal size from a list of faces
+         * Get a min heap according to the diagonals' weighted lengths from a list of faces
          * @param faces The list of faces
-         * @return The diagonal min heap
+         * @return The diagonal min heap, one entry per diagonal
         */
-        static std::vector<mesh::Diagonal*> getMinHeap(std::vector<mesh::Face*> faces);
+        static std::vector<mesh::DiagonalEntry> getMinHeap(std::vector<mesh::Face*> faces);
 
         /**
-         * Compare two diagonals
-         * @param d1 The first diagonal
-         * @param d2 The second diagonal
-         * @return The diagonal with the shortest length
+         * Compare two heap entries by the priorities they were pushed with, for the std heap functions
+         * The faces' ids break the ties, so the order doesn't depend on where the diagonals are allocated
+         * @param d1 The first entry
+         * @param d2 The second entry
+         * @return True if the first entry is popped after the second one
         */
-        static mesh::Diagonal* cmpDiagonal(mesh::Diagonal* d1, mesh::Diagonal* d2);
+        static bool cmpDiagonal(const mesh::DiagonalEntry & d1, const mesh::DiagonalEntry & d2);
 
         /**
          * Test if a face is a doublet
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+namespace mesh{
+
+/**
+ * A structure to represent the options of the mesh loaders, so each load chooses its own
+*/
+struct LoadOptions{
+    /**
+     * Tolerance for welding the duplicated vertices, relative to the bounding box's diagonal (0 to keep every vertex)
+    */
+    float weldTolerance = 0.0f;
+
+    /**
+     * Tells if the fitmaps are reused and stored between loads
+    */
+    bool fitmapsCache = true;
+
+    /**
+     * Directory of the fitmap cache files, empty to store them next to the loaded files
+    */
+    std::string fitmapsCacheDir = "";
+
+    /**
+     * Tells if the loaded mesh is built with its elements in cache friendly order, and reorders them at the end of triToQuad
+    */
+    bool reorder = false;
+};
+
+}
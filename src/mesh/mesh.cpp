@@ -1,100 +1,282 @@
 #include <cstdio>
 #include <string>
 #include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <numeric>
+#include <cstdint>
 #include <cassert>
 #include <vector>
 #include <queue>
 #include <map>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <charconv>
 #include <chrono>
+#include <thread>
+#include <functional>
+#include <unistd.h>
 
 #include "edge.hpp"
 #include "face.hpp"
+#include "circulators.hpp"
 #include "mesh.hpp"
 #include "vector3.hpp"
+#include "vector3Batch.hpp"
 #include "utils.hpp"
+#include "mappedFile.hpp"
+#include "objParser.hpp"
+#include "plyParser.hpp"
+#include "vertexWelder.hpp"
+#include "meshArchive.hpp"
 
 int mesh::Mesh::H_FITMAP = 8;
 float mesh::Mesh::THO_FITMAP = 0.05f;
+int mesh::Mesh::MAX_NEIGHBOURHOOD = 1024;
+
+namespace{
+
+/**
+ * The number of elements checked by each task of checkCorrectness
+*/
+constexpr int CHECK_CHUNK_SIZE = 1 << 14;
+
+/**
+ * Check if an element is in its list and not flagged to delete
+ * @param list The list
+ * @param element The element, which can be null
+ * @return True if it is
+*/
+template<typename T>
+bool isListed(const std::vector<T*> & list, const T* element){
+	return element && element->mSlot >= 0 && element->mSlot < int(list.size())
+		&& list[element->mSlot] == element && !element->mToDelete;
+}
+
+}
+
+std::string mesh::Mesh::Violation::toString() const{
+	static const char* KINDS[] = {"count", "slot", "deleted", "link", "face ring", "singlet", "doublet",
+		"vertex anchor", "vertex ring", "reverse", "duplicate edge"};
+	static const char* ELEMENTS[] = {"vertex", "face", "edge"};
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), "%s: %s %d", KINDS[kind], ELEMENTS[element], slot);
+	return buffer;
+}
+
+void mesh::Mesh::CorrectnessReport::print() const{
+	fprintf(stdout, "%d violations\n", int(violations.size()));
+	for(const Violation & violation : violations) fprintf(stdout, "%s\n", violation.toString().c_str());
+}
+
+mesh::Mesh::CorrectnessReport mesh::Mesh::checkCorrectness() const {
+	CorrectnessReport report;
 
-void mesh::Mesh::checkCorrectness() const {
-	// printf("\nBeg check correctness\n");
 	// check number of elements
-	assert(mNbFaces == int(mFaces.size()));
-	assert(mNbEdges == int(mEdges.size()));
-	assert(mNbVertices == int(mVertices.size()));
-
-	// check turn right
-	std::vector<mesh::Edge*> surEdges;
-	// turn arround every faces
-	// printf("\nBeg check faces\n");
-	for(int i=0; i<mNbFaces; i++){
-		// mFaces[i]->print();
-		assert(!mFaces[i]->mToDelete);
-		assert(!mFaces[i]->mEdge->mToDelete);
-		surEdges = mFaces[i]->getSurroundingEdges();
-		assert(!mesh::Edge::hasDoubles(surEdges));
-		assert(!mFaces[i]->isSinglet());
-		assert(mFaces[i]->isDoublet().size() == 0);
-	}
-	// printf("End check faces\n");
-
-	// turn arround every edges
-	// printf("\nBeg check edges\n");
-	for(int i=0; i<mNbEdges; i++){
-		assert(!mEdges[i]->mToDelete);
-		assert(!mEdges[i]->mEdgeLeftCCW->mToDelete);
-		assert(!mEdges[i]->mEdgeLeftCW->mToDelete);
-		assert(!mEdges[i]->mEdgeRightCW->mToDelete);
-		assert(!mEdges[i]->mEdgeRightCCW->mToDelete);
-		assert(!mEdges[i]->mReverseEdge->mToDelete);
-		surEdges = mEdges[i]->mFaceLeft->getSurroundingEdges();
-		assert(!mesh::Edge::hasDoubles(surEdges));
-		surEdges = mEdges[i]->mFaceRight->getSurroundingEdges();
-		assert(!mesh::Edge::hasDoubles(surEdges));
-		// mEdges[i]->print();
-		// assert(mEdges[i]->check());
-	}
-	// printf("End check edges\n");
-
-
-	// turn arround every vertices
-	// printf("\nBeg check vertices\n");
-	for(int i=0; i<mNbVertices; i++){
-		assert(!mVertices[i]->mToDelete);
-		assert(!mVertices[i]->mEdge->mToDelete);
-		surEdges = mVertices[i]->mEdge->mFaceLeft->getSurroundingEdges();
-		assert(!mesh::Edge::hasDoubles(surEdges));
-		surEdges = mVertices[i]->mEdge->mFaceRight->getSurroundingEdges();
-		assert(!mesh::Edge::hasDoubles(surEdges));
+	if(mNbVertices != int(mVertices.size())) report.violations.push_back({Violation::COUNT, Violation::VERTEX, -1});
+	if(mNbFaces != int(mFaces.size())) report.violations.push_back({Violation::COUNT, Violation::FACE, -1});
+	if(mNbEdges != int(mEdges.size())) report.violations.push_back({Violation::COUNT, Violation::EDGE, -1});
+
+	// the lists are checked by chunks on all the cores, the first task looks for the duplicated edges meanwhile
+	int nbFaceChunks = (int(mFaces.size()) + CHECK_CHUNK_SIZE - 1) / CHECK_CHUNK_SIZE;
+	int nbEdgeChunks = (int(mEdges.size()) + CHECK_CHUNK_SIZE - 1) / CHECK_CHUNK_SIZE;
+	int nbVertexChunks = (int(mVertices.size()) + CHECK_CHUNK_SIZE - 1) / CHECK_CHUNK_SIZE;
+	std::vector<std::vector<Violation>> found(1 + nbFaceChunks + nbEdgeChunks + nbVertexChunks);
+	utils::parallelFor(int(found.size()), [&](int task){
+		int chunk = task - 1;
+		if(task == 0){
+			checkDuplicateEdges(found[task]);
+		}
+		else if(chunk < nbFaceChunks){
+			int begin = chunk * CHECK_CHUNK_SIZE;
+			int end = std::min(begin + CHECK_CHUNK_SIZE, int(mFaces.size()));
+			for(int i=begin; i<end; i++) checkFace(i, true, found[task]);
+		}
+		else if((chunk -= nbFaceChunks) < nbEdgeChunks){
+			int begin = chunk * CHECK_CHUNK_SIZE;
+			int end = std::min(begin + CHECK_CHUNK_SIZE, int(mEdges.size()));
+			for(int i=begin; i<end; i++) checkEdge(i, found[task]);
+		}
+		else{
+			int begin = (chunk - nbEdgeChunks) * CHECK_CHUNK_SIZE;
+			int end = std::min(begin + CHECK_CHUNK_SIZE, int(mVertices.size()));
+			for(int i=begin; i<end; i++) checkVertex(i, found[task]);
+		}
+	});
+
+	// the faces, the edges and the vertices in the order of their lists, then the duplicates
+	for(int i=1; i<int(found.size()); i++) report.violations.insert(report.violations.end(), found[i].begin(), found[i].end());
+	report.violations.insert(report.violations.end(), found[0].begin(), found[0].end());
+	return report;
+}
+
+void mesh::Mesh::checkFace(int i, bool shapes, std::vector<Violation> & violations) const{
+	const mesh::Face* face = mFaces[i];
+	if(!face){
+		violations.push_back({Violation::LINK, Violation::FACE, i});
+		return;
+	}
+	if(face->mSlot != i) violations.push_back({Violation::SLOT, Violation::FACE, i});
+	if(face->mToDelete) violations.push_back({Violation::DELETED, Violation::FACE, i});
+	if(!isListed(mEdges, face->mEdge)){
+		violations.push_back({Violation::LINK, Violation::FACE, i});
+		return;
 	}
-	// printf("End check vertices\n");
 
-	// check reversed
-	// printf("\nBeg check reversed\n");
-	for(int i=0; i<mNbEdges; i++){
-		mesh::Edge* curEdge = mEdges[i];
-		mesh::Edge* revEdge = curEdge->mReverseEdge;
-		assert(curEdge->mReverseEdge);
-		assert(curEdge->mVertexOrigin      == revEdge->mVertexDestination);
-		assert(curEdge->mVertexDestination == revEdge->mVertexOrigin);
-		assert(curEdge->mFaceLeft  == revEdge->mFaceRight);
-		assert(curEdge->mFaceRight == revEdge->mFaceLeft);
-		assert(curEdge->mEdgeLeftCCW  == revEdge->mEdgeRightCCW->mReverseEdge);
-		assert(curEdge->mEdgeLeftCW   == revEdge->mEdgeRightCW->mReverseEdge);
-		assert(curEdge->mEdgeRightCCW == revEdge->mEdgeLeftCCW->mReverseEdge);
-		assert(curEdge->mEdgeRightCW  == revEdge->mEdgeLeftCW->mReverseEdge);
+	// turn around the face without trusting the links, so a broken ring is not followed forever
+	const mesh::Vertex* vertices[4];
+	int nbVertices = 0;
+	bool closed = false;
+	bool doublet = false;
+	const mesh::Edge* curEdge = face->mEdge;
+	for(int nbSteps=0; nbSteps<int(mEdges.size()) && isListed(mEdges, curEdge); nbSteps++){
+		// the edge going into an inner singlet has the face on both sides
+		if(curEdge->mFaceRight != face || (shapes && curEdge->mFaceLeft == face)) break;
+		if(!curEdge->check()) doublet = true;
+		// the distinct vertices, a singlet has three
+		bool seen = nbVertices == 4;
+		for(int j=0; j<nbVertices && !seen; j++) seen = vertices[j] == curEdge->mVertexOrigin;
+		if(!seen) vertices[nbVertices++] = curEdge->mVertexOrigin;
+		curEdge = curEdge->mEdgeRightCW;
+		if(curEdge == face->mEdge){
+			closed = true;
+			break;
+		}
+	}
+	if(!closed){
+		violations.push_back({Violation::FACE_RING, Violation::FACE, i});
+		return;
+	}
+	if(!shapes) return;
+	if(nbVertices == 3) violations.push_back({Violation::SINGLET, Violation::FACE, i});
+	if(doublet) violations.push_back({Violation::DOUBLET, Violation::FACE, i});
+}
+
+void mesh::Mesh::checkEdge(int i, std::vector<Violation> & violations) const{
+	const mesh::Edge* curEdge = mEdges[i];
+	if(!curEdge){
+		violations.push_back({Violation::LINK, Violation::EDGE, i});
+		return;
+	}
+	if(curEdge->mSlot != i) violations.push_back({Violation::SLOT, Violation::EDGE, i});
+	if(curEdge->mToDelete) violations.push_back({Violation::DELETED, Violation::EDGE, i});
+	if(!isListed(mVertices, curEdge->mVertexOrigin) || !isListed(mVertices, curEdge->mVertexDestination)
+		|| !isListed(mFaces, curEdge->mFaceLeft) || !isListed(mFaces, curEdge->mFaceRight)
+		|| !isListed(mEdges, curEdge->mEdgeLeftCW) || !isListed(mEdges, curEdge->mEdgeLeftCCW)
+		|| !isListed(mEdges, curEdge->mEdgeRightCW) || !isListed(mEdges, curEdge->mEdgeRightCCW)
+		|| !isListed(mEdges, curEdge->mReverseEdge)){
+		violations.push_back({Violation::LINK, Violation::EDGE, i});
+		return;
 	}
-	// printf("End check reversed\n");
 
+	// check reversed, a reversed edge with broken links is reported on its own
+	const mesh::Edge* revEdge = curEdge->mReverseEdge;
+	if(!revEdge->mEdgeLeftCW || !revEdge->mEdgeLeftCCW || !revEdge->mEdgeRightCW || !revEdge->mEdgeRightCCW) return;
+	if(revEdge->mReverseEdge != curEdge
+		|| curEdge->mVertexOrigin != revEdge->mVertexDestination
+		|| curEdge->mVertexDestination != revEdge->mVertexOrigin
+		|| curEdge->mFaceLeft != revEdge->mFaceRight
+		|| curEdge->mFaceRight != revEdge->mFaceLeft
+		|| curEdge->mEdgeLeftCCW != revEdge->mEdgeRightCCW->mReverseEdge
+		|| curEdge->mEdgeLeftCW != revEdge->mEdgeRightCW->mReverseEdge
+		|| curEdge->mEdgeRightCCW != revEdge->mEdgeLeftCCW->mReverseEdge
+		|| curEdge->mEdgeRightCW != revEdge->mEdgeLeftCW->mReverseEdge){
+		violations.push_back({Violation::REVERSE, Violation::EDGE, i});
+	}
+}
 
-	// check edges' edges
-	// printf("\nBeg check unique edges\n");
-	assert(!mesh::Vertex::twoSameEdges(mEdges, mNbVertices));
-	// printf("End check unique edges\n");
+void mesh::Mesh::checkVertex(int i, std::vector<Violation> & violations) const{
+	const mesh::Vertex* vertex = mVertices[i];
+	if(!vertex){
+		violations.push_back({Violation::LINK, Violation::VERTEX, i});
+		return;
+	}
+	if(vertex->mSlot != i) violations.push_back({Violation::SLOT, Violation::VERTEX, i});
+	if(vertex->mToDelete) violations.push_back({Violation::DELETED, Violation::VERTEX, i});
+	if(!isListed(mEdges, vertex->mEdge)){
+		violations.push_back({Violation::LINK, Violation::VERTEX, i});
+		return;
+	}
+	if(vertex->mEdge->mVertexOrigin != vertex && vertex->mEdge->mVertexDestination != vertex){
+		violations.push_back({Violation::VERTEX_ANCHOR, Violation::VERTEX, i});
+		return;
+	}
 
-	// printf("\nEnd check correctness\n");
+	// turn around the vertex through its outgoing edges without trusting the links
+	const mesh::Edge* firstEdge = vertex->mEdge->mVertexOrigin == vertex ? vertex->mEdge : vertex->mEdge->mReverseEdge;
+	const mesh::Edge* curEdge = firstEdge;
+	bool closed = false;
+	for(int nbSteps=0; nbSteps<int(mEdges.size()) && isListed(mEdges, curEdge) && curEdge->mVertexOrigin == vertex; nbSteps++){
+		if(!isListed(mEdges, curEdge->mEdgeRightCCW)) break;
+		curEdge = curEdge->mEdgeRightCCW->mReverseEdge;
+		if(curEdge == firstEdge){
+			closed = true;
+			break;
+		}
+	}
+	if(!closed) violations.push_back({Violation::VERTEX_RING, Violation::VERTEX, i});
+}
+
+void mesh::Mesh::validateAround(const char* operation, const std::vector<mesh::Face*> & faces) const{
+	std::vector<Violation> violations;
+	std::vector<int> faceSlots, edgeSlots, vertexSlots;
+
+	// gather the one-ring of the living faces, the checks walk the rings again without trusting them
+	for(const mesh::Face* face : faces){
+		if(face->mToDelete) continue;
+		if(!isListed(mFaces, face)){
+			violations.push_back({Violation::SLOT, Violation::FACE, face->mSlot});
+			continue;
+		}
+		faceSlots.push_back(face->mSlot);
+		const mesh::Edge* curEdge = face->mEdge;
+		for(int nbSteps=0; nbSteps<int(mEdges.size()) && isListed(mEdges, curEdge); nbSteps++){
+			edgeSlots.push_back(curEdge->mSlot);
+			if(isListed(mEdges, curEdge->mReverseEdge)) edgeSlots.push_back(curEdge->mReverseEdge->mSlot);
+			if(isListed(mVertices, curEdge->mVertexOrigin)) vertexSlots.push_back(curEdge->mVertexOrigin->mSlot);
+			curEdge = curEdge->mEdgeRightCW;
+			if(curEdge == face->mEdge) break;
+		}
+	}
+
+	// the faces are shared by the seeds, the edges and the vertices by the faces
+	for(std::vector<int>* slots : {&faceSlots, &edgeSlots, &vertexSlots}){
+		std::sort(slots->begin(), slots->end());
+		slots->erase(std::unique(slots->begin(), slots->end()), slots->end());
+	}
+	// the singlets and the doublets are legal until removeDoublets is done
+	for(int i : faceSlots) checkFace(i, false, violations);
+	for(int i : edgeSlots) checkEdge(i, violations);
+	for(int i : vertexSlots) checkVertex(i, violations);
+
+	if(!violations.empty()){
+		std::fprintf(stderr, "Error, %s broke the mesh around %d faces!\n", operation, int(faces.size()));
+		CorrectnessReport{violations}.print();
+		throw std::logic_error("Need a correct mesh after each operation!\n");
+	}
+}
+
+void mesh::Mesh::checkDuplicateEdges(std::vector<Violation> & violations) const{
+	// a flat hash set of the (origin, destination) pairs with linear probing, kept under half full
+	size_t mask = 1023;
+	while(mask + 1 < 2*mEdges.size()) mask = 2*mask + 1;
+	std::vector<uint64_t> keys(mask + 1);
+	std::vector<char> used(mask + 1, 0);
+	for(int i=0; i<int(mEdges.size()); i++){
+		const mesh::Edge* curEdge = mEdges[i];
+		if(!curEdge || !curEdge->mVertexOrigin || !curEdge->mVertexDestination) continue;
+		uint64_t key = edgeKey(curEdge->mVertexOrigin->mId, curEdge->mVertexDestination->mId);
+		uint64_t hash = key ^ (key >> 33);
+		hash *= 0xff51afd7ed558ccdULL;
+		size_t slot = (hash ^ (hash >> 33)) & mask;
+		while(used[slot] && keys[slot] != key) slot = (slot + 1) & mask;
+		if(used[slot]){
+			violations.push_back({Violation::DUPLICATE_EDGE, Violation::EDGE, i});
+			continue;
+		}
+		used[slot] = 1;
+		keys[slot] = key;
+	}
 }
 
 std::vector<std::string> mesh::Mesh::verticesToString() const {
@@ -140,6 +322,24 @@ void mesh::Mesh::printStats() const{
 	fprintf(stdout, "Mesh: nbVert=%d, nbFaces=%d, nbEdges=%d\n", mNbVertices, mNbFaces, mNbEdges);
 }
 
+mesh::Mesh::MemoryStats mesh::Mesh::getMemoryStats() const{
+	return {mStorage->vertices.stats(), mStorage->faces.stats(), mStorage->edges.stats(), mStorage->diagonals.stats()};
+}
+
+void mesh::Mesh::printMemoryStats() const{
+	MemoryStats stats = getMemoryStats();
+	const std::pair<const char*, const mesh::PoolStats*> pools[] = {
+		{"vertices", &stats.vertices}, {"faces", &stats.faces}, {"edges", &stats.edges}, {"diagonals", &stats.diagonals}
+	};
+	size_t bytes = 0;
+	for(const auto & pool : pools){
+		fprintf(stdout, "Memory %s: alive=%zu, highWater=%zu, capacity=%zu, bytes=%zu\n", 
+			pool.first, pool.second->size, pool.second->highWater, pool.second->capacity, pool.second->bytes);
+		bytes += pool.second->bytes;
+	}
+	fprintf(stdout, "Memory total: bytes=%zu\n", bytes);
+}
+
 
 void mesh::Mesh::print() const{
 	std::vector<std::string> strings = toString();
@@ -162,132 +362,200 @@ void mesh::Mesh::print() const{
 	}
 }
 
-mesh::Mesh mesh::Mesh::loadOBJ(std::string file){
-	// init index counters
-	mesh::Vertex::ID_CPT = 0;
-	mesh::Face::ID_CPT = 0;
-	mesh::Edge::ID_CPT = 0;
+mesh::Mesh mesh::Mesh::loadOBJ(std::string file, const mesh::LoadOptions & options){
+	// map the file and parse the vertices and faces in place on all the cores
+	mesh::RawMesh raw;
+	utils::MappedFile objFile(file);
+	mesh::ObjParser::parseParallel(objFile.begin(), objFile.end(), raw);
 
-	std::vector<maths::Vector3*> vertices;
-	std::vector<std::vector<int>> faces;
-	
-	std::ifstream objFile(file.c_str());
-	if (!objFile){
-        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
-		throw std::invalid_argument("Need a file as input!\n");
-    }
+	// merge the duplicated vertices before building the connectivity
+	if (options.weldTolerance > 0.0f) mesh::VertexWelder::weld(raw, options.weldTolerance);
 
-	// load vertices and faces
-	std::string line;
-	while (std::getline(objFile, line)) 
-	{
-		if (line.length() < 2)
-			continue;
+	// sort the vertices and faces so the connectivity and the fitmaps are built in cache friendly order
+	if (options.reorder) reorderRawMesh(raw);
 
-		else if (line[0] == 'v' && line[1] == ' ') 
-		{
-			// load a vertex
-			line.erase(line.begin());
-			std::istringstream iss(line);
-            float x,y,z;
-			iss >> x >> y >> z;
-			maths::Vector3* v = new maths::Vector3(x,y,z);
-			vertices.push_back(v);
-		}
-		else if (line[0] == 'f') 
-		{
-			// load a face
-			line.erase(line.begin());
-			faces.resize(faces.size() + 1);
-			std::istringstream iss(line);
-			int idx;
-			char binBSlash;
-			int binIdx;
-			/*
-			check if format:
-			f v1 v2 v3
-			or
-			f v1/./. v2/./. v3/./.
-			*/
-			std::size_t found = line.find("/");
-  			if (found == std::string::npos){
-				while (iss >> idx)
-					faces.back().push_back(idx - 1);
-			} else {
-				while (iss >> idx >> binBSlash >> binIdx >> binBSlash >> binIdx){
-					faces.back().push_back(idx - 1);
-				}
-			}
-		}
-		else 
-			continue;
-	}
+	// convert the mesh to winged-edge form
+	mesh::Mesh mesh = mesh::Mesh::objToMesh(raw);
+	mesh.initFitmaps(raw, file, options);
+	mesh.setReorder(options.reorder);
+	return mesh;
+}
+
+mesh::Mesh mesh::Mesh::loadPLY(std::string file, const mesh::LoadOptions & options){
+	// map the file and read the vertices and faces in place
+	mesh::RawMesh raw;
+	utils::MappedFile plyFile(file);
+	mesh::PlyParser::parse(plyFile.begin(), plyFile.end(), raw);
+
+	// merge the duplicated vertices before building the connectivity
+	if (options.weldTolerance > 0.0f) mesh::VertexWelder::weld(raw, options.weldTolerance);
+
+	// sort the vertices and faces so the connectivity and the fitmaps are built in cache friendly order
+	if (options.reorder) reorderRawMesh(raw);
+
+	// convert the mesh to winged-edge form
+	mesh::Mesh mesh = mesh::Mesh::objToMesh(raw);
+	mesh.initFitmaps(raw, file, options);
+	mesh.setReorder(options.reorder);
+	return mesh;
+}
+
+void mesh::Mesh::setReorder(bool enabled){
+	mReorder = enabled;
+}
+
+void mesh::Mesh::setLocalValidation(bool enabled){
+	mLocalValidation = enabled;
+}
 
-	mesh::Mesh mesh = mesh::Mesh::objToMesh(vertices, faces);
+void mesh::Mesh::setParallelPairing(bool enabled){
+	mParallelPairing = enabled;
+}
 
+void mesh::Mesh::initFitmaps(const mesh::RawMesh &raw, std::string file, const mesh::LoadOptions & options){
 	// auto start = std::chrono::high_resolution_clock::now();
-	mesh.buildFitmaps();
+	// the fitmaps only depend on the geometry and the parameters, reuse them if already built
+	if (!options.fitmapsCache){
+		buildFitmaps();
+	}
+	else{
+		uint64_t key = fitmapsKey(raw);
+		std::string cacheFile = fitmapsCacheFile(file, key, options.fitmapsCacheDir);
+		if (!loadFitmaps(cacheFile, key)){
+			buildFitmaps();
+			if (!saveFitmaps(cacheFile, key)){
+				std::fprintf(stderr, "Warning, failed to write the fitmap cache %s!\n", cacheFile.c_str());
+			}
+		}
+	}
 	// auto stop = std::chrono::high_resolution_clock::now();
 	// auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
     // printf("time build fitmaps: %f\n", double(duration.count()));
+}
 
-	// convert the mesh to winged-edge form
-	return mesh;
+
+mesh::Vertex* mesh::Mesh::newVertex(float x, float y, float z){
+	mesh::Vertex* vertex = mStorage->vertices.create(maths::Vector3(x, y, z));
+	vertex->mId = mStorage->nextVertexId++;
+	return vertex;
 }
 
+mesh::Face* mesh::Mesh::newFace(){
+	mesh::Face* face = mStorage->faces.create();
+	face->mId = mStorage->nextFaceId++;
+	return face;
+}
+
+mesh::Edge* mesh::Mesh::newEdge(){
+	mesh::Edge* edge = mStorage->edges.create();
+	edge->mId = mStorage->nextEdgeId++;
+	return edge;
+}
+
+void mesh::Mesh::deleteVertex(mesh::Vertex* vertex){
+	mStorage->vertices.destroy(vertex);
+}
+
+void mesh::Mesh::deleteFace(mesh::Face* face){
+	if(face->mDiagonal) mStorage->diagonals.destroy(face->mDiagonal);
+	mStorage->faces.destroy(face);
+}
+
+void mesh::Mesh::deleteEdge(mesh::Edge* edge){
+	mStorage->edges.destroy(edge);
+}
+
+void mesh::Mesh::setDiagonal(mesh::Face* face, float weight){
+	mesh::Diagonal* diag = face->mDiagonal;
+	face->createDiagonal(mStorage->diagonals);
+	if(face->mDiagonal) face->mDiagonal->weight = weight;
+	else if(diag) mStorage->droppedDiagonals.push_back(diag);
+}
+
+void mesh::Mesh::pushDiagonal(mesh::Diagonal* diag){
+	diag->priority = diag->weightedLength();
+	mDiagHeap.push_back({diag->priority, diag->face->mId, diag});
+	std::push_heap(mDiagHeap.begin(), mDiagHeap.end(), mesh::Face::cmpDiagonal);
+}
+
+mesh::Mesh mesh::Mesh::objToMesh(const mesh::RawMesh &raw){
+	if (raw.nbFaces() == 0){
+		std::fprintf(stderr, "Error, the mesh has no faces!\n");
+		throw std::invalid_argument("Need at least one face as input!\n");
+	}
+
+	// the elements of each kind are created one after the other in the mesh's storage
+	mesh::Mesh mesh(0, 0, 0, {}, {}, {});
+	mesh.mStorage->vertices.reserve(raw.nbVertices());
+	mesh.mStorage->faces.reserve(raw.nbFaces());
+	mesh.mStorage->edges.reserve(raw.indices.size());
 
-mesh::Mesh mesh::Mesh::objToMesh(std::vector<maths::Vector3*> &vertices, std::vector<std::vector<int>> &faces){
 	// create mesh::Vertex and save to vertexlist
 	std::vector<mesh::Vertex*> vertexList;
-	int nbVertices = int(vertices.size());
+	int nbVertices = raw.nbVertices();
+	vertexList.reserve(nbVertices);
 	for (int i = 0; i < nbVertices; i++)
-		vertexList.push_back(new mesh::Vertex(vertices[i]));
+		vertexList.push_back(mesh.newVertex(raw.coords[3*i], raw.coords[3*i+1], raw.coords[3*i+2]));
+
+	// every face may have its own number of vertices, so a face's edges start at its offset in the indices
+	int nbFaces = raw.nbFaces();
+	for (int i = 0; i < nbFaces; i++){
+		if (raw.faceSize(i) < 3 || raw.faceSize(i) > 4){
+			std::fprintf(stderr, "Error, face %d has %d vertices!\n", i, raw.faceSize(i));
+			throw std::invalid_argument("Need a mesh of triangles and quads as input!\n");
+		}
+	}
+	for (int i = 0; i < int(raw.indices.size()); i++){
+		if (raw.indices[i] < 0 || raw.indices[i] >= raw.nbVertices()){
+			std::fprintf(stderr, "Error, a face uses the vertex %d which does not exist!\n", raw.indices[i] + 1);
+			throw std::invalid_argument("Need a correct mesh as input!\n");
+		}
+	}
 
 	// create mesh::Edge and save to edge
     std::vector<mesh::Edge*> edgeList;
-	int vnum = faces[0].size();
-	int nbEdges = int(faces.size()*vnum);
+	int nbEdges = int(raw.indices.size());
+	edgeList.reserve(nbEdges);
 	for (int i = 0; i < nbEdges; i++){
-		mesh::Edge* newEdge = new mesh::Edge();
-		edgeList.push_back(newEdge);
+		edgeList.push_back(mesh.newEdge());
 	}
 
 	// create mesh::Face and save to face
     std::vector<mesh::Face*> faceList;
-	int nbFaces = int(faces.size());
+	faceList.reserve(nbFaces);
 	for (int i = 0; i < nbFaces; i++){
-		faceList.push_back(new mesh::Face());
-		if(vnum > 3){
-			faceList.back()->mIsTriangle = false;
-		}
+		faceList.push_back(mesh.newFace());
+		faceList.back()->mIsTriangle = raw.faceSize(i) == 3;
 	}
 
 
-	// use edgetable to record indices of start and end vertex, edge index
-	int m = vertices.size();
-	// printf("vnum: %d, m: %d\n", vnum, m);
-	// printf("nbVertices: %d, nbFaces: %d\n", m, int(faces.size()));
+	// use a sparse table keyed by (start vertex, end vertex) to record the edge indices
+	// so the memory grows with the number of edges instead of the square of the number of vertices
+	std::unordered_map<uint64_t, int> edgeTable;
+	edgeTable.reserve(nbEdges);
 
-	std::vector<std::vector<int>> edgeTable(m, std::vector<int>(m, -1));
+	// the normals go to their channel once the faces have their slots
+	std::vector<maths::Vector3> normals(nbFaces);
 
-	for (int i = 0; i < int(faces.size()); i++) {
+	for (int i = 0; i < nbFaces; i++) {
 		mesh::Face* f = faceList[i];
+		int first = raw.offsets[i];
+		int vnum = raw.faceSize(i);
+		const int* face = &raw.indices[first];
 		
-		std::vector<maths::Vector3*> pointsOfPlane;
+		std::vector<const maths::Vector3*> pointsOfPlane;
 
 		for (int v = 0; v < vnum; v++) {
-			int v0 = faces[i][v];
-			int v1 = faces[i][(v+1)%vnum];
+			int v0 = face[v];
+			int v1 = face[(v+1)%vnum];
 
-			int idx = vnum*i + v;
+			int idx = first + v;
 
 			mesh::Vertex* vStart; 
 			mesh::Vertex* vEnd;
 			mesh::Edge* eCur;
-			mesh::Edge* eNext = edgeList[vnum*i + (v + 1) % vnum];
-			mesh::Edge* ePrev = edgeList[vnum*i + (v - 1 + vnum) % vnum];
-
-			// printf("v0: %d, v1: %d, idx: %d, lccw: %d, lcw: %d\n", v0, v1, idx, vnum*i + (v + 1) % vnum, vnum*i + (v - 1 + vnum) % vnum);
+			mesh::Edge* eNext = edgeList[first + (v + 1) % vnum];
+			mesh::Edge* ePrev = edgeList[first + (v - 1 + vnum) % vnum];
 
 			vStart = vertexList[v0];
 			vEnd = vertexList[v1];
@@ -295,7 +563,7 @@ mesh::Mesh mesh::Mesh::objToMesh(std::vector<maths::Vector3*> &vertices, std::ve
 			vStart->mNeighbours.push_back(vEnd);
 			vStart->mNeighboursFaces.push_back(f);
 
-			pointsOfPlane.push_back(vStart->mCoords);
+			pointsOfPlane.push_back(&vStart->mCoords);
 
 			eCur = edgeList[idx];
 
@@ -306,43 +574,56 @@ mesh::Mesh mesh::Mesh::objToMesh(std::vector<maths::Vector3*> &vertices, std::ve
 			eCur->mEdgeRightCCW = ePrev;
 			eCur->mFaceRight = f;
 
-			edgeTable[v0][v1] = idx;
-			int revIdx = edgeTable[v1][v0];
-			if(revIdx != -1){
-				eCur->mReverseEdge = edgeList[revIdx];
-				edgeList[revIdx]->mReverseEdge = eCur;
+			if(!edgeTable.emplace(mesh::Mesh::edgeKey(v0, v1), idx).second){
+				std::fprintf(stderr, "Error, the edge from %d to %d is used twice, the mesh is not manifold!\n", v0 + 1, v1 + 1);
+				throw std::invalid_argument("Need a manifold mesh as input!\n");
+			}
+			auto rev = edgeTable.find(mesh::Mesh::edgeKey(v1, v0));
+			if(rev != edgeTable.end()){
+				eCur->mReverseEdge = edgeList[rev->second];
+				edgeList[rev->second]->mReverseEdge = eCur;
 			}
 			f->mEdge = eCur;
 			vStart->mEdge = eCur;
 		}
 
 		// create the normal
-		f->mNormal = maths::Vector3::getNormalOfPlane(pointsOfPlane[0], pointsOfPlane[1], pointsOfPlane[2]);
+		normals[i] = maths::Vector3::getNormalOfPlane(*pointsOfPlane[0], *pointsOfPlane[1], *pointsOfPlane[2]);
 
 	}
 
-	// save left according to the table
-	for (int i = 0; i < m; i++){
-		for (int j = 0; j < m; j++){
-			int idx = edgeTable[i][j];
-			if (idx != -1){
-				mesh::Edge *edge = edgeList[idx];
-				int flipIdx = edgeTable[j][i];
-				// printf("idx: %d, flip: %d\n", idx, flipIdx);
-				mesh::Edge *edgeFlip = edgeList[flipIdx];
-
-				edge->mEdgeLeftCW = edgeFlip->mEdgeRightCW->mReverseEdge;
-				edge->mEdgeLeftCCW = edgeFlip->mEdgeRightCCW->mReverseEdge; 
-				edge->mFaceLeft = edgeFlip->mFaceRight;
-			}
+	// every edge needs its reversed one to build the left side
+	for (int i = 0; i < nbEdges; i++){
+		if (edgeList[i]->mReverseEdge == nullptr){
+			std::fprintf(stderr, "Error, edge %d has no reversed edge, the mesh is not closed!\n", i);
+			throw std::invalid_argument("Need a closed mesh as input!\n");
 		}
 	}
 
+	// save left according to the reversed edges
+	for (int i = 0; i < nbEdges; i++){
+		mesh::Edge *edge = edgeList[i];
+		mesh::Edge *edgeFlip = edge->mReverseEdge;
+
+		edge->mEdgeLeftCW = edgeFlip->mEdgeRightCW->mReverseEdge;
+		edge->mEdgeLeftCCW = edgeFlip->mEdgeRightCCW->mReverseEdge; 
+		edge->mFaceLeft = edgeFlip->mFaceRight;
+	}
+
 	assert(nbVertices == int(vertexList.size()));
 	assert(nbFaces == int(faceList.size()));
 	assert(nbEdges == int(edgeList.size()));
 
-    return * new mesh::Mesh(nbVertices, nbFaces, nbEdges, vertexList, faceList, edgeList);
+	mesh.mNbVertices = nbVertices;
+	mesh.mNbFaces = nbFaces;
+	mesh.mNbEdges = nbEdges;
+	mesh.mVertices = std::move(vertexList);
+	mesh.mFaces = std::move(faceList);
+	mesh.mEdges = std::move(edgeList);
+	mesh.indexSlots();
+	mesh::AttributeChannel<maths::Vector3> & faceNormals = mesh.faceAttributes().attach<maths::Vector3>(NORMAL);
+	for (int i = 0; i < nbFaces; i++) faceNormals[i] = normals[i];
+	return mesh;
 
 }
 
@@ -358,7 +639,84 @@ std::vector<std::vector<mesh::Vertex *>> mesh::Mesh::verticesOfFaces(){
 }
 
 
-void mesh::Mesh::toObj(std::string file){
+namespace{
+
+/**
+ * Number of vertices or faces formatted per chunk of an obj file
+*/
+const int OBJ_CHUNK_SIZE = 1 << 15;
+
+/**
+ * Longest formatted float or index, "-1.23457e+38" takes 12 characters
+*/
+const int OBJ_MAX_NUMBER_SIZE = 16;
+
+void appendFloat(std::string & buffer, float value){
+	char number[OBJ_MAX_NUMBER_SIZE];
+	// same as the default ostream formatting of floats (%g)
+	char* end = std::to_chars(number, number + OBJ_MAX_NUMBER_SIZE, value, std::chars_format::general, 6).ptr;
+	buffer.append(number, end);
+}
+
+void appendInt(std::string & buffer, int value){
+	char number[OBJ_MAX_NUMBER_SIZE];
+	char* end = std::to_chars(number, number + OBJ_MAX_NUMBER_SIZE, value).ptr;
+	buffer.append(number, end);
+}
+
+/**
+ * Get the slots of the vertices around a face by walking around its edges,
+ * like getSurroundingVertices a vertex is kept once
+*/
+void surroundingVertexSlots(const mesh::Face* face, std::vector<int> & ids){
+	ids.clear();
+	const mesh::Edge* e0 = face->mEdge;
+	const mesh::Edge* curEdge = e0;
+	do{
+		int id = curEdge->mVertexOrigin->mSlot;
+		if (std::find(ids.begin(), ids.end(), id) == ids.end()) ids.push_back(id);
+		assert(curEdge->mFaceRight->mId == face->mId);
+		curEdge = curEdge->mEdgeRightCW;
+	}while(curEdge->mId != e0->mId);
+}
+
+}
+
+void mesh::Mesh::toObjChunk(int chunk, int nbVertexChunks, std::string & buffer) const{
+	buffer.clear();
+
+	// export vertices
+	if (chunk < nbVertexChunks){
+		int end = std::min(int(mVertices.size()), (chunk+1)*OBJ_CHUNK_SIZE);
+		for (int i = chunk*OBJ_CHUNK_SIZE; i < end; i++){
+			const maths::Vector3* v = &mVertices[i]->mCoords;
+			buffer += "v ";
+			appendFloat(buffer, v->x());
+			buffer += ' ';
+			appendFloat(buffer, v->y());
+			buffer += ' ';
+			appendFloat(buffer, v->z());
+			buffer += '\n';
+		}
+		return;
+	}
+
+	// export faces
+	std::vector<int> ids;
+	chunk -= nbVertexChunks;
+	int end = std::min(int(mFaces.size()), (chunk+1)*OBJ_CHUNK_SIZE);
+	for (int i = chunk*OBJ_CHUNK_SIZE; i < end; i++){
+		surroundingVertexSlots(mFaces[i], ids);
+		buffer += 'f';
+		for (int id : ids){
+			buffer += ' ';
+			appendInt(buffer, id + 1);
+		}
+		buffer += '\n';
+	}
+}
+
+void mesh::Mesh::toObj(std::string file, bool parallel){
 	// check whether we could create the file
 	std::ofstream objFile(file);
 	if (!objFile){
@@ -366,61 +724,769 @@ void mesh::Mesh::toObj(std::string file){
 		throw std::invalid_argument("Need a file as input!\n");
     }
 
-	// extract the face list from winged-edge mesh
-	std::vector<std::vector<mesh::Vertex *>> faces = verticesOfFaces();
-
 	// put number of vertices and faces as commtent
-	objFile << "# " << mNbVertices << " " << mNbFaces << std::endl;
+	std::string buffer = "# ";
+	appendInt(buffer, mNbVertices);
+	buffer += ' ';
+	appendInt(buffer, mNbFaces);
+	buffer += '\n';
+	objFile.write(buffer.data(), buffer.size());
+
+	int nbVertexChunks = (int(mVertices.size()) + OBJ_CHUNK_SIZE - 1) / OBJ_CHUNK_SIZE;
+	int nbFaceChunks = (int(mFaces.size()) + OBJ_CHUNK_SIZE - 1) / OBJ_CHUNK_SIZE;
+	int nbChunks = nbVertexChunks + nbFaceChunks;
+
+	if (!parallel || nbChunks <= 1 || utils::nbThreads() <= 1){
+		// format and write the chunks one by one in the same buffer
+		for (int i = 0; i < nbChunks; i++){
+			toObjChunk(i, nbVertexChunks, buffer);
+			objFile.write(buffer.data(), buffer.size());
+		}
+	}
+	else{
+		// format the chunks on all the cores, then write them in order
+		std::vector<std::string> buffers(nbChunks);
+		utils::parallelFor(nbChunks, [&](int i){
+			toObjChunk(i, nbVertexChunks, buffers[i]);
+		});
+		for (int i = 0; i < nbChunks; i++){
+			objFile.write(buffers[i].data(), buffers[i].size());
+		}
+	}
 
-	// export vertices
-	for (int i = 0; i < int(mVertices.size()); i++) 
-	{
-		maths::Vector3* v = mVertices[i]->mCoords;
-		objFile << "v " << v->x()
-			<< " " << v->y()
-			<< " " << v->z() << std::endl;
+	if (!objFile){
+        std::fprintf(stderr, "Error, failed to write %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+	}
+}
+
+namespace{
+
+/**
+ * The header of a binary snapshot, followed by flat arrays:
+ * vertices' coordinates (3 floats), edge (int), S and M fitmaps (floats),
+ * faces' edge (int), flags (int), normal (3 floats), S and M fitmaps (floats),
+ * edges' links (9 ints: origin, destination, left face, right face, lcw, lccw, rcw, rccw, reversed)
+ * and the radii (floats)
+*/
+struct BinaryHeader{
+	uint32_t magic;
+	uint32_t version;
+	int32_t nbVertices;
+	int32_t nbFaces;
+	int32_t nbEdges;
+	int32_t nbRadii;
+};
+
+const int32_t FACE_IS_TRIANGLE = 1;
+
+template<typename T>
+void writeArray(std::ofstream & binFile, const std::vector<T> & array){
+	binFile.write(reinterpret_cast<const char*>(array.data()), array.size()*sizeof(T));
+}
+
+template<typename T>
+const T* readArray(const char* & cur, size_t size){
+	const T* array = reinterpret_cast<const T*>(cur);
+	cur += size*sizeof(T);
+	return array;
+}
+
+template<typename T>
+int32_t indexOf(const std::vector<T*> & list, const T* element){
+	// an element is in the list when its slot points back to it
+	if(!element || element->mSlot < 0 || element->mSlot >= int(list.size()) || list[element->mSlot] != element){
+		std::fprintf(stderr, "Error, an element is linked to a removed one, clean the mesh first!\n");
+		throw std::invalid_argument("Need a clean mesh as input!\n");
 	}
+	return element->mSlot;
+}
 
-	int idx;
+/**
+ * Get the copy of an element from the copy of its list
+ * @param list The list of the element
+ * @param copies The copies of the list's elements, in the same order
+ * @param element The element, which must be in the list
+ * @return The copy, nullptr for nullptr
+*/
+template<typename T>
+T* copyOf(const std::vector<T*> & list, const std::vector<T*> & copies, const T* element){
+	if(element == nullptr) return nullptr;
+	if(element->mSlot < 0 || element->mSlot >= int(list.size()) || list[element->mSlot] != element){
+		std::fprintf(stderr, "Error, an element is linked to a removed one, clean the mesh first!\n");
+		throw std::invalid_argument("Need a clean mesh as input!\n");
+	}
+	return copies[element->mSlot];
+}
+
+}
+
+void mesh::Mesh::toPLY(std::string file, bool fitmaps){
+	std::ofstream plyFile(file, std::ios::binary);
+	if (!plyFile){
+        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+    }
+
+	std::string buffer = "ply\nformat binary_little_endian 1.0\n";
+	buffer += "element vertex " + std::to_string(mVertices.size()) + "\n";
+	buffer += "property float x\nproperty float y\nproperty float z\n";
+	if (fitmaps) buffer += "property float s_fitmap\nproperty float m_fitmap\n";
+	buffer += "element face " + std::to_string(mFaces.size()) + "\n";
+	buffer += "property list uchar int vertex_indices\n";
+	buffer += "end_header\n";
+	plyFile.write(buffer.data(), buffer.size());
+
+	// export vertices, the slots being the indices in the list, zeros for a mesh without fitmaps
+	const mesh::AttributeChannel<float>* sFitmaps = vertexAttributes().find<float>(S_FITMAP);
+	const mesh::AttributeChannel<float>* mFitmaps = vertexAttributes().find<float>(M_FITMAP);
+	std::vector<float> vertices;
+	vertices.reserve(mVertices.size() * (fitmaps ? 5 : 3));
+	for (int i = 0; i < int(mVertices.size()); i++){
+		const mesh::Vertex* v = mVertices[i];
+		vertices.push_back(v->mCoords.x());
+		vertices.push_back(v->mCoords.y());
+		vertices.push_back(v->mCoords.z());
+		if (fitmaps){
+			vertices.push_back(sFitmaps ? (*sFitmaps)[i] : 0.0f);
+			vertices.push_back(mFitmaps ? (*mFitmaps)[i] : 0.0f);
+		}
+	}
+	writeArray(plyFile, vertices);
 
 	// export faces
-	for (int i = 0; i < int(faces.size()); i++) 
-	{
-		objFile << "f";
-
-		for (int j = 0; j < int(faces[i].size()); j++)
-		{
-			idx = faces[i][j]->mId;
-			objFile << " " << idx + 1;
+	std::vector<int> ids;
+	buffer.clear();
+	for (int i = 0; i < int(mFaces.size()); i++){
+		surroundingVertexSlots(mFaces[i], ids);
+		if (ids.size() > 255){
+			std::fprintf(stderr, "Error, a face has more than 255 vertices!\n");
+			throw std::invalid_argument("Need faces with less than 256 vertices!\n");
+		}
+		buffer += char(uint8_t(ids.size()));
+		for (int id : ids){
+			int32_t idx = id;
+			buffer.append(reinterpret_cast<const char*>(&idx), sizeof(idx));
 		}
-		objFile << std::endl;
+	}
+	plyFile.write(buffer.data(), buffer.size());
+
+	if (!plyFile){
+        std::fprintf(stderr, "Error, failed to write %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
 	}
 }
 
-void mesh::Mesh::triToQuadRemovalMarkingPhase(){
-	// create a list of candidates for all faces
-	std::vector<mesh::Edge*> candidateEdges;
-	for (int i=0; i<int(mFaces.size()); i++){
-		mesh::Edge* edgeToRemove = nullptr;
-		float minSquared = INFINITY;
-		float maxLength = -INFINITY;
+mesh::RawMesh mesh::Mesh::toRaw() const{
+	mesh::RawMesh raw;
+	raw.coords.reserve(3*mVertices.size());
+	for (int i = 0; i < int(mVertices.size()); i++){
+		const maths::Vector3* v = &mVertices[i]->mCoords;
+		raw.coords.push_back(v->x());
+		raw.coords.push_back(v->y());
+		raw.coords.push_back(v->z());
+	}
 
-		// for all edges surrounding the face
-		std::vector<mesh::Edge*> surEdges = mFaces[i]->getSurroundingEdges();
-		// print();
-		for (int j=0; j<int(surEdges.size()); j++){
-			mesh::Edge* curEdge = surEdges[j];
-			// get the sum of pairwised dot product
-			std::vector<mesh::Vertex*> newQuadVertices = {
-				curEdge->mEdgeLeftCW->mVertexOrigin,
-				curEdge->mVertexDestination,
-				curEdge->mEdgeRightCW->mVertexDestination,
-				curEdge->mVertexOrigin
-			};
-			float sumDotProd = mesh::Edge::getSumPairwiseDotProd(newQuadVertices);
-			float length = curEdge->getLength();
+	std::vector<int> ids;
+	raw.offsets.reserve(mFaces.size() + 1);
+	for (int i = 0; i < int(mFaces.size()); i++){
+		surroundingVertexSlots(mFaces[i], ids);
+		raw.indices.insert(raw.indices.end(), ids.begin(), ids.end());
+		raw.offsets.push_back(int(raw.indices.size()));
+	}
+	return raw;
+}
+
+void mesh::Mesh::appendToArchive(std::string file, int bits) const{
+	std::ofstream archiveFile(file, std::ios::binary | std::ios::app);
+	if (!archiveFile){
+        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+    }
+
+	float min[3] = {getMinWidth(), getMinHeight(), getMinDepth()};
+	float max[3] = {getMaxWidth(), getMaxHeight(), getMaxDepth()};
+	std::string level;
+	mesh::MeshArchive::encode(toRaw(), min, max, bits, level);
+	archiveFile.write(level.data(), level.size());
+
+	if (!archiveFile){
+        std::fprintf(stderr, "Error, failed to write %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+	}
+}
+
+int mesh::Mesh::archiveLevels(std::string file){
+	utils::MappedFile archiveFile(file);
+	const char* cur = archiveFile.begin();
+	int nbLevels = 0;
+	while (cur != archiveFile.end()){
+		mesh::MeshArchive::skip(cur, archiveFile.end());
+		nbLevels++;
+	}
+	return nbLevels;
+}
+
+mesh::Mesh mesh::Mesh::loadArchive(std::string file, int level, const mesh::LoadOptions & options){
+	// skip the previous levels and decode the wanted one in place
+	utils::MappedFile archiveFile(file);
+	const char* cur = archiveFile.begin();
+	for (int i = 0; i < level; i++){
+		if (cur == archiveFile.end()) break;
+		mesh::MeshArchive::skip(cur, archiveFile.end());
+	}
+	if (level < 0 || cur == archiveFile.end()){
+        std::fprintf(stderr, "Error, %s has no level %d!\n", file.c_str(), level);
+		throw std::invalid_argument("Need an existing level as input!\n");
+	}
+	mesh::RawMesh raw;
+	mesh::MeshArchive::decode(cur, archiveFile.end(), raw);
+
+	// sort the vertices and faces so the connectivity and the fitmaps are built in cache friendly order
+	if (options.reorder) reorderRawMesh(raw);
+
+	// convert the mesh to winged-edge form, every level has its own fitmap cache
+	mesh::Mesh mesh = mesh::Mesh::objToMesh(raw);
+	mesh.initFitmaps(raw, file + "." + std::to_string(level), options);
+	mesh.setReorder(options.reorder);
+	return mesh;
+}
+
+void mesh::Mesh::saveBinary(std::string file){
+	std::ofstream binFile(file, std::ios::binary);
+	if (!binFile){
+        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+    }
+
+	// the channels are indexed like the lists, the missing ones are saved as zeros
+	const mesh::AttributeChannel<float>* sFitmaps = vertexAttributes().find<float>(S_FITMAP);
+	const mesh::AttributeChannel<float>* mFitmaps = vertexAttributes().find<float>(M_FITMAP);
+	const mesh::AttributeChannel<maths::Vector3>* normals = faceAttributes().find<maths::Vector3>(NORMAL);
+	const mesh::AttributeChannel<float>* faceSFitmapChannel = faceAttributes().find<float>(S_FITMAP);
+	const mesh::AttributeChannel<float>* faceMFitmapChannel = faceAttributes().find<float>(M_FITMAP);
+
+	// flatten the vertices
+	std::vector<float> vertexCoords(3*mNbVertices);
+	std::vector<int32_t> vertexEdges(mNbVertices);
+	std::vector<float> vertexSFitmaps(mNbVertices);
+	std::vector<float> vertexMFitmaps(mNbVertices);
+	for(int i=0; i<mNbVertices; i++){
+		mesh::Vertex* v = mVertices[i];
+		vertexCoords[3*i] = v->mCoords.x();
+		vertexCoords[3*i+1] = v->mCoords.y();
+		vertexCoords[3*i+2] = v->mCoords.z();
+		vertexEdges[i] = indexOf(mEdges, v->mEdge);
+		vertexSFitmaps[i] = sFitmaps ? (*sFitmaps)[i] : 0.0f;
+		vertexMFitmaps[i] = mFitmaps ? (*mFitmaps)[i] : 0.0f;
+	}
+
+	// flatten the faces
+	std::vector<int32_t> faceEdges(mNbFaces);
+	std::vector<int32_t> faceFlags(mNbFaces);
+	std::vector<float> faceNormals(3*mNbFaces);
+	std::vector<float> faceSFitmaps(mNbFaces);
+	std::vector<float> faceMFitmaps(mNbFaces);
+	for(int i=0; i<mNbFaces; i++){
+		mesh::Face* f = mFaces[i];
+		maths::Vector3 normal = normals ? (*normals)[i] : maths::Vector3();
+		faceEdges[i] = indexOf(mEdges, f->mEdge);
+		faceFlags[i] = f->mIsTriangle ? FACE_IS_TRIANGLE : 0;
+		faceNormals[3*i] = normal.x();
+		faceNormals[3*i+1] = normal.y();
+		faceNormals[3*i+2] = normal.z();
+		faceSFitmaps[i] = faceSFitmapChannel ? (*faceSFitmapChannel)[i] : 0.0f;
+		faceMFitmaps[i] = faceMFitmapChannel ? (*faceMFitmapChannel)[i] : 0.0f;
+	}
+
+	// flatten the edges
+	std::vector<int32_t> edgeLinks(9*mNbEdges);
+	for(int i=0; i<mNbEdges; i++){
+		mesh::Edge* e = mEdges[i];
+		int32_t* links = &edgeLinks[9*i];
+		links[0] = indexOf(mVertices, e->mVertexOrigin);
+		links[1] = indexOf(mVertices, e->mVertexDestination);
+		links[2] = indexOf(mFaces, e->mFaceLeft);
+		links[3] = indexOf(mFaces, e->mFaceRight);
+		links[4] = indexOf(mEdges, e->mEdgeLeftCW);
+		links[5] = indexOf(mEdges, e->mEdgeLeftCCW);
+		links[6] = indexOf(mEdges, e->mEdgeRightCW);
+		links[7] = indexOf(mEdges, e->mEdgeRightCCW);
+		links[8] = indexOf(mEdges, e->mReverseEdge);
+	}
+
+	BinaryHeader header = {BINARY_MAGIC, BINARY_VERSION, mNbVertices, mNbFaces, mNbEdges, int32_t(mRadii.size())};
+	binFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeArray(binFile, vertexCoords);
+	writeArray(binFile, vertexEdges);
+	writeArray(binFile, vertexSFitmaps);
+	writeArray(binFile, vertexMFitmaps);
+	writeArray(binFile, faceEdges);
+	writeArray(binFile, faceFlags);
+	writeArray(binFile, faceNormals);
+	writeArray(binFile, faceSFitmaps);
+	writeArray(binFile, faceMFitmaps);
+	writeArray(binFile, edgeLinks);
+	writeArray(binFile, mRadii);
+
+	if (!binFile){
+        std::fprintf(stderr, "Error, failed to write %s!\n", file.c_str());
+		throw std::invalid_argument("Need a file as input!\n");
+	}
+}
+
+mesh::Mesh mesh::Mesh::loadBinary(std::string file){
+	utils::MappedFile binFile(file);
+	const char* cur = binFile.begin();
+
+	// check the header
+	BinaryHeader header;
+	if(binFile.size() < sizeof(header)){
+        std::fprintf(stderr, "Error, %s is not a mesh snapshot!\n", file.c_str());
+		throw std::invalid_argument("Need a binary snapshot as input!\n");
+	}
+	std::memcpy(&header, cur, sizeof(header));
+	cur += sizeof(header);
+	if(header.magic != BINARY_MAGIC || header.version != BINARY_VERSION){
+        std::fprintf(stderr, "Error, %s is not a mesh snapshot of version %u!\n", file.c_str(), BINARY_VERSION);
+		throw std::invalid_argument("Need a binary snapshot as input!\n");
+	}
+	int nbVertices = header.nbVertices;
+	int nbFaces = header.nbFaces;
+	int nbEdges = header.nbEdges;
+	int nbRadii = header.nbRadii;
+	size_t expectedSize = sizeof(header) 
+		+ size_t(nbVertices)*(3*sizeof(float) + sizeof(int32_t) + 2*sizeof(float))
+		+ size_t(nbFaces)*(2*sizeof(int32_t) + 5*sizeof(float))
+		+ size_t(nbEdges)*9*sizeof(int32_t)
+		+ size_t(nbRadii)*sizeof(float);
+	if(nbVertices < 0 || nbFaces < 0 || nbEdges < 0 || nbRadii < 0 || binFile.size() != expectedSize){
+        std::fprintf(stderr, "Error, %s is truncated!\n", file.c_str());
+		throw std::invalid_argument("Need a binary snapshot as input!\n");
+	}
+
+	// the arrays are read directly from the mapped file
+	const float* vertexCoords = readArray<float>(cur, 3*nbVertices);
+	const int32_t* vertexEdges = readArray<int32_t>(cur, nbVertices);
+	const float* vertexSFitmaps = readArray<float>(cur, nbVertices);
+	const float* vertexMFitmaps = readArray<float>(cur, nbVertices);
+	const int32_t* faceEdges = readArray<int32_t>(cur, nbFaces);
+	const int32_t* faceFlags = readArray<int32_t>(cur, nbFaces);
+	const float* faceNormals = readArray<float>(cur, 3*nbFaces);
+	const float* faceSFitmaps = readArray<float>(cur, nbFaces);
+	const float* faceMFitmaps = readArray<float>(cur, nbFaces);
+	const int32_t* edgeLinks = readArray<int32_t>(cur, 9*nbEdges);
+	const float* radii = readArray<float>(cur, nbRadii);
+
+	// check the indices before following them
+	for(int i=0; i<nbVertices; i++) 
+		if(vertexEdges[i] < 0 || vertexEdges[i] >= nbEdges) throw std::invalid_argument("Incorrect vertex in the binary snapshot!\n");
+	for(int i=0; i<nbFaces; i++) 
+		if(faceEdges[i] < 0 || faceEdges[i] >= nbEdges) throw std::invalid_argument("Incorrect face in the binary snapshot!\n");
+	for(int i=0; i<nbEdges; i++){
+		const int32_t* links = &edgeLinks[9*i];
+		bool correct = links[0] >= 0 && links[0] < nbVertices && links[1] >= 0 && links[1] < nbVertices
+			&& links[2] >= 0 && links[2] < nbFaces && links[3] >= 0 && links[3] < nbFaces;
+		for(int j=4; j<9; j++) correct = correct && links[j] >= 0 && links[j] < nbEdges;
+		if(!correct) throw std::invalid_argument("Incorrect edge in the binary snapshot!\n");
+	}
+
+	// create the elements one after the other in the mesh's storage
+	mesh::Mesh mesh(0, 0, 0, {}, {}, {});
+	mesh.mStorage->vertices.reserve(nbVertices);
+	mesh.mStorage->faces.reserve(nbFaces);
+	mesh.mStorage->edges.reserve(nbEdges);
+	std::vector<mesh::Vertex*> vertexList(nbVertices);
+	std::vector<mesh::Face*> faceList(nbFaces);
+	std::vector<mesh::Edge*> edgeList(nbEdges);
+	for(int i=0; i<nbVertices; i++) 
+		vertexList[i] = mesh.newVertex(vertexCoords[3*i], vertexCoords[3*i+1], vertexCoords[3*i+2]);
+	for(int i=0; i<nbFaces; i++) faceList[i] = mesh.newFace();
+	for(int i=0; i<nbEdges; i++) edgeList[i] = mesh.newEdge();
+
+	// fix up the links
+	for(int i=0; i<nbVertices; i++){
+		mesh::Vertex* v = vertexList[i];
+		v->mEdge = edgeList[vertexEdges[i]];
+	}
+	for(int i=0; i<nbFaces; i++){
+		mesh::Face* f = faceList[i];
+		f->mEdge = edgeList[faceEdges[i]];
+		f->mIsTriangle = faceFlags[i] & FACE_IS_TRIANGLE;
+	}
+	for(int i=0; i<nbEdges; i++){
+		mesh::Edge* e = edgeList[i];
+		const int32_t* links = &edgeLinks[9*i];
+		e->mVertexOrigin = vertexList[links[0]];
+		e->mVertexDestination = vertexList[links[1]];
+		e->mFaceLeft = faceList[links[2]];
+		e->mFaceRight = faceList[links[3]];
+		e->mEdgeLeftCW = edgeList[links[4]];
+		e->mEdgeLeftCCW = edgeList[links[5]];
+		e->mEdgeRightCW = edgeList[links[6]];
+		e->mEdgeRightCCW = edgeList[links[7]];
+		e->mReverseEdge = edgeList[links[8]];
+	}
+
+	mesh.mNbVertices = nbVertices;
+	mesh.mNbFaces = nbFaces;
+	mesh.mNbEdges = nbEdges;
+	mesh.mVertices = std::move(vertexList);
+	mesh.mFaces = std::move(faceList);
+	mesh.mEdges = std::move(edgeList);
+	mesh.indexSlots();
+	mesh.mRadii.assign(radii, radii + nbRadii);
+
+	// fill the channels, the slots being the indices in the snapshot
+	std::copy(vertexSFitmaps, vertexSFitmaps + nbVertices, mesh.vertexAttributes().attach<float>(S_FITMAP).data());
+	std::copy(vertexMFitmaps, vertexMFitmaps + nbVertices, mesh.vertexAttributes().attach<float>(M_FITMAP).data());
+	std::copy(faceSFitmaps, faceSFitmaps + nbFaces, mesh.faceAttributes().attach<float>(S_FITMAP).data());
+	std::copy(faceMFitmaps, faceMFitmaps + nbFaces, mesh.faceAttributes().attach<float>(M_FITMAP).data());
+	mesh::AttributeChannel<maths::Vector3> & normals = mesh.faceAttributes().attach<maths::Vector3>(NORMAL);
+	for(int i=0; i<nbFaces; i++) normals[i] = maths::Vector3(faceNormals[3*i], faceNormals[3*i+1], faceNormals[3*i+2]);
+	return mesh;
+}
+
+mesh::Mesh mesh::Mesh::clone() const{
+	std::vector<int> vertexOrder(mVertices.size());
+	std::vector<int> faceOrder(mFaces.size());
+	std::vector<int> edgeOrder(mEdges.size());
+	std::iota(vertexOrder.begin(), vertexOrder.end(), 0);
+	std::iota(faceOrder.begin(), faceOrder.end(), 0);
+	std::iota(edgeOrder.begin(), edgeOrder.end(), 0);
+	return copyInOrder(vertexOrder, faceOrder, edgeOrder);
+}
+
+mesh::AttributeSet & mesh::Mesh::vertexAttributes(){
+	return mStorage->vertexAttributes;
+}
+
+const mesh::AttributeSet & mesh::Mesh::vertexAttributes() const{
+	return mStorage->vertexAttributes;
+}
+
+mesh::AttributeSet & mesh::Mesh::faceAttributes(){
+	return mStorage->faceAttributes;
+}
+
+const mesh::AttributeSet & mesh::Mesh::faceAttributes() const{
+	return mStorage->faceAttributes;
+}
+
+mesh::AttributeSet & mesh::Mesh::edgeAttributes(){
+	return mStorage->edgeAttributes;
+}
+
+const mesh::AttributeSet & mesh::Mesh::edgeAttributes() const{
+	return mStorage->edgeAttributes;
+}
+
+mesh::Mesh mesh::Mesh::copyInOrder(const std::vector<int> & vertexOrder, const std::vector<int> & faceOrder, 
+		const std::vector<int> & edgeOrder) const{
+	mesh::Mesh mesh(0, 0, 0, {}, {}, {});
+	Storage & storage = *mesh.mStorage;
+	storage.vertices.reserve(mVertices.size());
+	storage.faces.reserve(mFaces.size());
+	storage.edges.reserve(mEdges.size());
+	storage.nextVertexId = mStorage->nextVertexId;
+	storage.nextFaceId = mStorage->nextFaceId;
+	storage.nextEdgeId = mStorage->nextEdgeId;
+
+	// copy the elements one after the other in the new pools, the links still going to this mesh
+	std::vector<mesh::Vertex*> vertexList(mVertices.size());
+	std::vector<mesh::Face*> faceList(mFaces.size());
+	std::vector<mesh::Edge*> edgeList(mEdges.size());
+	// the copies indexed like the originals
+	std::vector<mesh::Vertex*> vertexCopies(mVertices.size());
+	std::vector<mesh::Face*> faceCopies(mFaces.size());
+	std::vector<mesh::Edge*> edgeCopies(mEdges.size());
+	for(int i=0; i<int(mVertices.size()); i++){
+		const mesh::Vertex* v = mVertices[vertexOrder[i]];
+		// the neighbours are only used to build the fitmaps at load
+		mesh::Vertex* copy = storage.vertices.create(v->mCoords, v->mEdge);
+		copy->mId = v->mId;
+		copy->mToDelete = v->mToDelete;
+		vertexList[i] = vertexCopies[vertexOrder[i]] = copy;
+	}
+	for(int i=0; i<int(mFaces.size()); i++) 
+		faceList[i] = faceCopies[faceOrder[i]] = storage.faces.create(*mFaces[faceOrder[i]]);
+	for(int i=0; i<int(mEdges.size()); i++) 
+		edgeList[i] = edgeCopies[edgeOrder[i]] = storage.edges.create(*mEdges[edgeOrder[i]]);
+
+	// link the copies together
+	for(mesh::Vertex* v : vertexList) v->mEdge = copyOf(mEdges, edgeCopies, v->mEdge);
+	for(mesh::Face* f : faceList){
+		f->mEdge = copyOf(mEdges, edgeCopies, f->mEdge);
+		if(f->mDiagonal){
+			const mesh::Diagonal* diag = f->mDiagonal;
+			f->mDiagonal = storage.diagonals.create(mesh::Diagonal{f, copyOf(mVertices, vertexCopies, diag->v1),
+				copyOf(mVertices, vertexCopies, diag->v2), diag->length, diag->weight, diag->priority});
+		}
+	}
+	for(mesh::Edge* e : edgeList){
+		e->mVertexOrigin = copyOf(mVertices, vertexCopies, e->mVertexOrigin);
+		e->mVertexDestination = copyOf(mVertices, vertexCopies, e->mVertexDestination);
+		e->mFaceLeft = copyOf(mFaces, faceCopies, e->mFaceLeft);
+		e->mFaceRight = copyOf(mFaces, faceCopies, e->mFaceRight);
+		e->mEdgeLeftCW = copyOf(mEdges, edgeCopies, e->mEdgeLeftCW);
+		e->mEdgeLeftCCW = copyOf(mEdges, edgeCopies, e->mEdgeLeftCCW);
+		e->mEdgeRightCW = copyOf(mEdges, edgeCopies, e->mEdgeRightCW);
+		e->mEdgeRightCCW = copyOf(mEdges, edgeCopies, e->mEdgeRightCCW);
+		e->mReverseEdge = copyOf(mEdges, edgeCopies, e->mReverseEdge);
+	}
+
+	// the copies keep the priorities and the faces' ids cmpDiagonal orders them by, so the heap keeps its layout
+	// unless a stale entry is dropped
+	bool isHeap = true;
+	for(const mesh::DiagonalEntry & entry : mDiagHeap){
+		if(entry.isCurrent()){
+			mesh::Face* face = copyOf(mFaces, faceCopies, entry.diagonal->face);
+			mesh.mDiagHeap.push_back({entry.priority, entry.faceId, face->mDiagonal});
+		}
+		else isHeap = false;
+	}
+	if(!isHeap) std::make_heap(mesh.mDiagHeap.begin(), mesh.mDiagHeap.end(), mesh::Face::cmpDiagonal);
+
+	mesh.mNbVertices = mNbVertices;
+	mesh.mNbFaces = mNbFaces;
+	mesh.mNbEdges = mNbEdges;
+	mesh.mVertices = std::move(vertexList);
+	mesh.mFaces = std::move(faceList);
+	mesh.mEdges = std::move(edgeList);
+	assert(mStorage->vertexAttributes.size() == mVertices.size());
+	assert(mStorage->faceAttributes.size() == mFaces.size());
+	assert(mStorage->edgeAttributes.size() == mEdges.size());
+	storage.vertexAttributes = mStorage->vertexAttributes.copyInOrder(vertexOrder);
+	storage.faceAttributes = mStorage->faceAttributes.copyInOrder(faceOrder);
+	storage.edgeAttributes = mStorage->edgeAttributes.copyInOrder(edgeOrder);
+	mesh.indexSlots();
+	mesh.mFirstTriIdx = mFirstTriIdx;
+	mesh.mRadii = mRadii;
+	mesh.mCompaction = mCompaction;
+	mesh.mReorder = mReorder;
+	mesh.mLocalValidation = mLocalValidation;
+	mesh.mParallelPairing = mParallelPairing;
+	return mesh;
+}
+
+namespace{
+
+/**
+ * The number of bits of each coordinate in a Morton code
+*/
+constexpr int MORTON_BITS = 21;
+
+/**
+ * Spread the bits of a value so two zeros separate them
+ * @param x The value, on MORTON_BITS bits
+ * @return The spread bits
+*/
+uint64_t spreadBits(uint64_t x){
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffff;
+	x = (x | x << 16) & 0x1f0000ff0000ff;
+	x = (x | x << 8) & 0x100f00f00f00f00f;
+	x = (x | x << 4) & 0x10c30c30c30c30c3;
+	x = (x | x << 2) & 0x1249249249249249;
+	return x;
+}
+
+/**
+ * A Z-order curve over a bounding box
+*/
+struct ZOrderCurve{
+	/**
+	 * The box's minimum corner
+	*/
+	maths::Vector3 min;
+
+	/**
+	 * The number of curve steps per unit on each axis
+	*/
+	maths::Vector3 scale;
+
+	/**
+	 * Create the curve over the box of some points
+	 * @param coords The points' coordinates (x, y and z for each point)
+	 * @param nbPoints The number of points
+	*/
+	ZOrderCurve(const float* coords, int nbPoints){
+		float minCoords[3] = {INFINITY, INFINITY, INFINITY};
+		float maxCoords[3] = {-INFINITY, -INFINITY, -INFINITY};
+		for(int i=0; i<nbPoints; i++){
+			for(int k=0; k<3; k++){
+				minCoords[k] = std::min(minCoords[k], coords[3*i+k]);
+				maxCoords[k] = std::max(maxCoords[k], coords[3*i+k]);
+			}
+		}
+		const float steps = float((1 << MORTON_BITS) - 1);
+		float scales[3];
+		for(int k=0; k<3; k++) scales[k] = maxCoords[k] > minCoords[k] ? steps / (maxCoords[k] - minCoords[k]) : 0.0f;
+		min = maths::Vector3(minCoords[0], minCoords[1], minCoords[2]);
+		scale = maths::Vector3(scales[0], scales[1], scales[2]);
+	}
+
+	/**
+	 * Get the position of a point along the curve
+	 * @param p The point
+	 * @return The Morton code
+	*/
+	uint64_t code(const maths::Vector3 & p) const{
+		const uint64_t maxCoord = (uint64_t(1) << MORTON_BITS) - 1;
+		uint64_t x = std::min(maxCoord, uint64_t(std::max(0.0f, (p.x() - min.x()) * scale.x())));
+		uint64_t y = std::min(maxCoord, uint64_t(std::max(0.0f, (p.y() - min.y()) * scale.y())));
+		uint64_t z = std::min(maxCoord, uint64_t(std::max(0.0f, (p.z() - min.z()) * scale.z())));
+		return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+	}
+};
+
+/**
+ * Get the indices of elements sorted by their codes, ties keeping their order
+ * @param codes The codes of the elements
+ * @return The old index of each new position
+*/
+std::vector<int> sortByCodes(const std::vector<uint64_t> & codes){
+	std::vector<int> order(codes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&codes](int a, int b){ return codes[a] < codes[b]; });
+	return order;
+}
+
+}
+
+void mesh::Mesh::reorderRawMesh(mesh::RawMesh & raw){
+	if(raw.nbVertices() == 0) return;
+	ZOrderCurve curve(raw.coords.data(), raw.nbVertices());
+
+	// the vertices along the curve
+	std::vector<uint64_t> codes(raw.nbVertices());
+	for(int i=0; i<raw.nbVertices(); i++) 
+		codes[i] = curve.code(maths::Vector3(raw.coords[3*i], raw.coords[3*i+1], raw.coords[3*i+2]));
+	std::vector<int> vertexOrder = sortByCodes(codes);
+	std::vector<int> newIndices(raw.nbVertices());
+	std::vector<float> coords(raw.coords.size());
+	for(int i=0; i<raw.nbVertices(); i++){
+		newIndices[vertexOrder[i]] = i;
+		std::copy_n(&raw.coords[3*vertexOrder[i]], 3, &coords[3*i]);
+	}
+
+	// the faces along the curve by their centers
+	codes.resize(raw.nbFaces());
+	for(int i=0; i<raw.nbFaces(); i++){
+		maths::Vector3 center;
+		for(int j=raw.offsets[i]; j<raw.offsets[i+1]; j++){
+			const float* p = &raw.coords[3*raw.indices[j]];
+			center += maths::Vector3(p[0], p[1], p[2]);
+		}
+		codes[i] = curve.code(center / float(raw.faceSize(i)));
+	}
+	std::vector<int> faceOrder = sortByCodes(codes);
+	std::vector<int> indices;
+	std::vector<int> offsets = {0};
+	indices.reserve(raw.indices.size());
+	offsets.reserve(raw.offsets.size());
+	for(int i : faceOrder){
+		for(int j=raw.offsets[i]; j<raw.offsets[i+1]; j++) indices.push_back(newIndices[raw.indices[j]]);
+		offsets.push_back(int(indices.size()));
+	}
+
+	raw.coords = std::move(coords);
+	raw.indices = std::move(indices);
+	raw.offsets = std::move(offsets);
+}
+
+void mesh::Mesh::reorder(){
+	if(mVertices.empty()) return;
+
+	// the Z-order curve over the bounding box
+	std::vector<float> coords(3 * mVertices.size());
+	for(int i=0; i<int(mVertices.size()); i++){
+		coords[3*i] = mVertices[i]->mCoords.x();
+		coords[3*i+1] = mVertices[i]->mCoords.y();
+		coords[3*i+2] = mVertices[i]->mCoords.z();
+	}
+	ZOrderCurve curve(coords.data(), int(mVertices.size()));
+
+	// the vertices along the curve
+	std::vector<uint64_t> codes(mVertices.size());
+	for(int i=0; i<int(mVertices.size()); i++) codes[i] = curve.code(mVertices[i]->mCoords);
+	std::vector<int> vertexOrder = sortByCodes(codes);
+
+	// the faces along the curve by their centers
+	codes.resize(mFaces.size());
+	for(int i=0; i<int(mFaces.size()); i++){
+		maths::Vector3 center;
+		int nbVertices = 0;
+		for(mesh::Vertex* v : mesh::faceVertices(mFaces[i])){
+			center += v->mCoords;
+			nbVertices++;
+		}
+		codes[i] = curve.code(center / float(nbVertices));
+	}
+	std::vector<int> faceOrder = sortByCodes(codes);
+
+	// the edges face by face, each edge being on the right of one face
+	std::vector<int> edgeOrder;
+	edgeOrder.reserve(mEdges.size());
+	std::vector<bool> isPlaced(mEdges.size(), false);
+	for(int i : faceOrder){
+		for(mesh::Edge* e : mesh::faceEdges(mFaces[i])){
+			if(isPlaced[e->mSlot]) continue;
+			isPlaced[e->mSlot] = true;
+			edgeOrder.push_back(e->mSlot);
+		}
+	}
+	for(int i=0; i<int(mEdges.size()); i++) if(!isPlaced[i]) edgeOrder.push_back(i);
+
+	// move the elements in new pools in this order
+	// the old elements are released with their pools once no shallow copy uses them anymore
+	*this = copyInOrder(vertexOrder, faceOrder, edgeOrder);
+
+	// the new index of each old index
+	mCompaction.vertices.assign(vertexOrder.size(), -1);
+	mCompaction.faces.assign(faceOrder.size(), -1);
+	mCompaction.edges.assign(edgeOrder.size(), -1);
+	for(int i=0; i<int(vertexOrder.size()); i++) mCompaction.vertices[vertexOrder[i]] = i;
+	for(int i=0; i<int(faceOrder.size()); i++) mCompaction.faces[faceOrder[i]] = i;
+	for(int i=0; i<int(edgeOrder.size()); i++) mCompaction.edges[edgeOrder[i]] = i;
+}
+
+namespace{
+
+/**
+ * The number of edges or faces handled by each task of triToQuadRemovalMarkingPhase
+*/
+constexpr int MARKING_CHUNK_SIZE = 1 << 12;
+
+/**
+ * Check if removing an edge merges two triangles into a quad
+ * @param edge The edge
+ * @return True if both faces of the edge are triangles
+*/
+bool mergesTriangles(const mesh::Edge* edge){
+	return edge->mFaceLeft->isTriangle() && edge->mFaceRight->isTriangle();
+}
+
+/**
+ * Find the edge giving the squarest quad once removed from a triangle, only reading the mesh so the faces can be searched in parallel
+ * @param face The triangle
+ * @param sumDotProds The sum of the cosines of the quad's corners of each edge merging two triangles
+ * @return The edge, null if no neighbour is a triangle
+*/
+mesh::Edge* bestMergeEdge(const mesh::Face* face, const mesh::AttributeChannel<float> & sumDotProds){
+	mesh::Edge* edgeToRemove = nullptr;
+	float minSquared = INFINITY;
+	float maxLength = -INFINITY;
+
+	// for all edges surrounding the face, the direct ones then their reverse like getSurroundingEdges
+	for (int pass=0; pass<2; pass++){
+		for (mesh::Edge* ringEdge : mesh::faceEdges(face)){
+			mesh::Edge* curEdge = pass == 0 ? ringEdge : ringEdge->mReverseEdge;
+			if(!mergesTriangles(curEdge)) continue;
+			float sumDotProd = sumDotProds[curEdge->mSlot];
 			// update max sum
 			if(sumDotProd <= minSquared){
+				float length = curEdge->getLength();
 				if(sumDotProd < minSquared || length > maxLength){
 					minSquared = sumDotProd;
 					maxLength = length;
@@ -428,13 +1494,103 @@ void mesh::Mesh::triToQuadRemovalMarkingPhase(){
 				}
 			}
 		}
+	}
+	return edgeToRemove;
+}
+
+/**
+ * Get the edge standing for an edge and its reverse in the matching of the triangles
+ * @param edge One of the edges
+ * @return The edge of the pair with the lowest slot
+*/
+mesh::Edge* pairEdge(mesh::Edge* edge){
+	return edge->mSlot < edge->mReverseEdge->mSlot ? edge : edge->mReverseEdge;
+}
+
+/**
+ * Tell if a pair edge merges its triangles into a squarer quad than another one, the longest then the lowest slot wins a tie so the order is total
+ * @param e1 The first pair edge
+ * @param e2 The second pair edge, null if there is none yet
+ * @param sumDotProds The sum of the cosines of the quad's corners of each edge merging two triangles
+ * @return True if the first one is better
+*/
+bool betterMerge(const mesh::Edge* e1, const mesh::Edge* e2, const mesh::AttributeChannel<float> & sumDotProds){
+	if(e2 == nullptr) return true;
+	// a degenerated quad comes last
+	float score1 = std::isnan(sumDotProds[e1->mSlot]) ? INFINITY : sumDotProds[e1->mSlot];
+	float score2 = std::isnan(sumDotProds[e2->mSlot]) ? INFINITY : sumDotProds[e2->mSlot];
+	if(score1 != score2) return score1 < score2;
+	float length1 = e1->getLength();
+	float length2 = e2->getLength();
+	if(length1 != length2) return length1 > length2;
+	return e1->mSlot < e2->mSlot;
+}
+
+}
+
+void mesh::Mesh::triToQuadRemovalMarkingPhase(){
+	// the score of the candidates only lives during the marking
+	mesh::AttributeChannel<float> & sumDotProds = edgeAttributes().attach<float>(SUM_DOT_PROD);
+
+	// score every edge merging two triangles in one sweep, the quads' corners are gathered by component for the batched kernel
+	int nbEdgeChunks = (int(mEdges.size()) + MARKING_CHUNK_SIZE - 1) / MARKING_CHUNK_SIZE;
+	utils::parallelFor(nbEdgeChunks, [&](int chunk){
+		int end = std::min((chunk + 1) * MARKING_CHUNK_SIZE, int(mEdges.size()));
+		std::vector<int> slots;
+		slots.reserve(MARKING_CHUNK_SIZE);
+		for (int i=chunk * MARKING_CHUNK_SIZE; i<end; i++){
+			if(mergesTriangles(mEdges[i])) slots.push_back(i);
+		}
+		int nbQuads = int(slots.size());
+		std::vector<float> corners(12 * nbQuads);
+		std::vector<float> sums(nbQuads);
+		for (int j=0; j<nbQuads; j++){
+			const mesh::Edge* curEdge = mEdges[slots[j]];
+			const mesh::Vertex* quad[4] = {
+				curEdge->mEdgeLeftCW->mVertexOrigin,
+				curEdge->mVertexDestination,
+				curEdge->mEdgeRightCW->mVertexDestination,
+				curEdge->mVertexOrigin
+			};
+			for (int k=0; k<4; k++){
+				corners[(3*k)*nbQuads + j] = quad[k]->mCoords.x();
+				corners[(3*k+1)*nbQuads + j] = quad[k]->mCoords.y();
+				corners[(3*k+2)*nbQuads + j] = quad[k]->mCoords.z();
+			}
+		}
+		maths::Vector3Batch::sumQuadCornerCosines(corners.data(), nbQuads, sums.data());
+		for (int j=0; j<nbQuads; j++) sumDotProds[slots[j]] = sums[j];
+	});
+
+	if(mParallelPairing){
+		matchTriangles(sumDotProds);
+		edgeAttributes().detach(SUM_DOT_PROD);
+		return;
+	}
+
+	// pick the best edge of each triangle on all the cores, each face writes its own slot
+	std::vector<mesh::Edge*> candidates(mFaces.size(), nullptr);
+	int nbFaceChunks = (int(mFaces.size()) + MARKING_CHUNK_SIZE - 1) / MARKING_CHUNK_SIZE;
+	utils::parallelFor(nbFaceChunks, [&](int chunk){
+		int end = std::min((chunk + 1) * MARKING_CHUNK_SIZE, int(mFaces.size()));
+		for (int i=chunk * MARKING_CHUNK_SIZE; i<end; i++){
+			// only two triangles can be merged into a quad
+			if(mFaces[i]->isTriangle()) candidates[i] = bestMergeEdge(mFaces[i], sumDotProds);
+		}
+	});
 
-		edgeToRemove->mSumDotProd = minSquared;
-		candidateEdges.push_back(edgeToRemove);
+	// gather the candidates in the order of the faces, so the selection doesn't depend on the threads
+	std::vector<mesh::Edge*> candidateEdges;
+	candidateEdges.reserve(mFaces.size());
+	for (mesh::Edge* candidate : candidates){
+		// no neighbour triangle, left to triToPureQuad
+		if(candidate != nullptr) candidateEdges.push_back(candidate);
 	}
 
 	// make a max heap of the candidates
-	std::make_heap(candidateEdges.begin(), candidateEdges.end(), mesh::Edge::cmp);
+	std::make_heap(candidateEdges.begin(), candidateEdges.end(), [&sumDotProds](const mesh::Edge* e1, const mesh::Edge* e2){
+		return sumDotProds[e1->mSlot] < sumDotProds[e2->mSlot];
+	});
 	while(candidateEdges.size() > 0){
 		mesh::Edge* curEdge = candidateEdges.back();
 		candidateEdges.pop_back();
@@ -446,40 +1602,97 @@ void mesh::Mesh::triToQuadRemovalMarkingPhase(){
 			curEdge->mReverseEdge->mToDelete = true;
 		}
 	}
+	edgeAttributes().detach(SUM_DOT_PROD);
 }
 
-void mesh::Mesh::removeFaceFromList(mesh::Face* face){
-	for(int i = 0; i<int(mFaces.size()); i++){
-		if(mFaces[i]->mId == face->mId){
-			mFaces.erase(mFaces.begin()+i);
-			mNbFaces--;
-			delete(face);
-			return;
+void mesh::Mesh::matchTriangles(const mesh::AttributeChannel<float> & sumDotProds){
+	// the free triangles, a triangle is taken once its face is flagged to merge
+	std::vector<int> freeFaces;
+	for (int i=0; i<int(mFaces.size()); i++){
+		if(mFaces[i]->isTriangle() && !mFaces[i]->mToMerge) freeFaces.push_back(i);
+	}
+	std::vector<mesh::Edge*> proposals(mFaces.size(), nullptr);
+
+	while(freeFaces.size() > 0){
+		int nbChunks = (int(freeFaces.size()) + MARKING_CHUNK_SIZE - 1) / MARKING_CHUNK_SIZE;
+
+		// every free triangle proposes its best merge with a free neighbour triangle
+		utils::parallelFor(nbChunks, [&](int chunk){
+			int end = std::min((chunk + 1) * MARKING_CHUNK_SIZE, int(freeFaces.size()));
+			for (int i=chunk * MARKING_CHUNK_SIZE; i<end; i++){
+				mesh::Edge* best = nullptr;
+				for (mesh::Edge* ringEdge : mesh::faceEdges(mFaces[freeFaces[i]])){
+					if(!ringEdge->mFaceLeft->isTriangle() || ringEdge->mFaceLeft->mToMerge) continue;
+					mesh::Edge* curEdge = pairEdge(ringEdge);
+					if(betterMerge(curEdge, best, sumDotProds)) best = curEdge;
+				}
+				proposals[freeFaces[i]] = best;
+			}
+		});
+
+		// a merge proposed by both its triangles is the best one around them, so it can't conflict with another one
+		utils::parallelFor(nbChunks, [&](int chunk){
+			int end = std::min((chunk + 1) * MARKING_CHUNK_SIZE, int(freeFaces.size()));
+			for (int i=chunk * MARKING_CHUNK_SIZE; i<end; i++){
+				mesh::Face* face = mFaces[freeFaces[i]];
+				mesh::Edge* curEdge = proposals[face->mSlot];
+				if(curEdge == nullptr) continue;
+				mesh::Face* other = curEdge->mFaceLeft == face ? curEdge->mFaceRight : curEdge->mFaceLeft;
+				// the pair is flagged by its face with the lowest slot
+				if(proposals[other->mSlot] != curEdge || other->mSlot < face->mSlot) continue;
+				curEdge->mToDelete = true;
+				curEdge->mReverseEdge->mToDelete = true;
+				face->mToMerge = true;
+				other->mToMerge = true;
+			}
+		});
+
+		// the triangles without a free neighbour are left to triToPureQuad
+		int nbFree = 0;
+		for (int i : freeFaces){
+			if(proposals[i] != nullptr && !mFaces[i]->mToMerge) freeFaces[nbFree++] = i;
 		}
+		freeFaces.resize(nbFree);
 	}
 }
 
+namespace{
+
+/**
+ * Take an element out of its list by moving the last element into its slot
+ * @param list The list
+ * @param attributes The channels of the list, moved the same way
+ * @param element The element, which must be in the list
+*/
+template<typename T>
+void removeFromSlot(std::vector<T*> & list, mesh::AttributeSet & attributes, T* element){
+	assert(element->mSlot >= 0 && element->mSlot < int(list.size()) && list[element->mSlot] == element);
+	attributes.removeSlot(element->mSlot);
+	T* last = list.back();
+	list[element->mSlot] = last;
+	last->mSlot = element->mSlot;
+	list.pop_back();
+	element->mSlot = -1;
+}
+
+}
+
+void mesh::Mesh::removeFaceFromList(mesh::Face* face){
+	removeFromSlot(mFaces, mStorage->faceAttributes, face);
+	mNbFaces--;
+	deleteFace(face);
+}
+
 void mesh::Mesh::removeVertexFromList(mesh::Vertex* vertex){
-	for(int i = 0; i<int(mVertices.size()); i++){
-		if(mVertices[i]->mId == vertex->mId){
-			mVertices.erase(mVertices.begin()+i);
-			mNbVertices--;
-			delete(vertex);
-			return;
-		}
-	}
+	removeFromSlot(mVertices, mStorage->vertexAttributes, vertex);
+	mNbVertices--;
+	deleteVertex(vertex);
 }
 
 void mesh::Mesh::removeEdgeFromList(mesh::Edge* edge){
-	for(int i = 0; i<int(mEdges.size()); i++){
-		if(mEdges[i]->mId == edge->mId){
-			// delete edge;
-			mEdges.erase(mEdges.begin()+i);
-			mNbEdges--;
-			delete(edge);
-			return;
-		}
-	}
+	removeFromSlot(mEdges, mStorage->edgeAttributes, edge);
+	mNbEdges--;
+	deleteEdge(edge);
 }
 
 void mesh::Mesh::removeEdge(mesh::Edge* edge){
@@ -555,6 +1768,9 @@ void mesh::Mesh::removeMarkedEdges(){
 
 
 void mesh::Mesh::triToQuad(){
+	// quad meshes can go straight to the diagonal collapse
+	if(howManyTriangles() == 0) return;
+
 	// print();
 	triToQuadRemovalMarkingPhase();
 	// printStats();
@@ -570,6 +1786,8 @@ void mesh::Mesh::triToQuad(){
 	// printStats();
 	assert(howManyTriangles() == 0);
 
+	// the splits and merges scattered the elements in memory
+	if(mReorder) reorder();
 	// print();
 }
 
@@ -602,12 +1820,12 @@ void mesh::Mesh::createEdge(mesh::Face* face, mesh::Vertex* v1, mesh::Vertex* v2
 	// }
 
 	// initiate the new edges
-	mesh::Edge* edge = new mesh::Edge();
-	mesh::Edge* edgeRev = new mesh::Edge();
+	mesh::Edge* edge = newEdge();
+	mesh::Edge* edgeRev = newEdge();
 
 	// initiate the new faces
-	mesh::Face* halfFace1 = new mesh::Face();
-	mesh::Face* halfFace2 = new mesh::Face();
+	mesh::Face* halfFace1 = newFace();
+	mesh::Face* halfFace2 = newFace();
 
 	// update new faces
 	halfFace1->mEdge = edge;
@@ -690,13 +1908,19 @@ void mesh::Mesh::createEdge(mesh::Face* face, mesh::Vertex* v1, mesh::Vertex* v2
 	face->mToDelete = true;
 
 	// add new elements to list
+	halfFace1->mSlot = int(mFaces.size());
 	mFaces.push_back(halfFace1);
+	halfFace2->mSlot = int(mFaces.size());
 	mFaces.push_back(halfFace2);
 	mNbFaces += 2;
 
+	edge->mSlot = int(mEdges.size());
 	mEdges.push_back(edge);
+	edgeRev->mSlot = int(mEdges.size());
 	mEdges.push_back(edgeRev);
 	mNbEdges += 2;
+	mStorage->faceAttributes.resize(mFaces.size());
+	mStorage->edgeAttributes.resize(mEdges.size());
 
 	// check if new faces are triangles
 	surEdges = halfFace1->getSurroundingEdges();
@@ -704,6 +1928,8 @@ void mesh::Mesh::createEdge(mesh::Face* face, mesh::Vertex* v1, mesh::Vertex* v2
 	surEdges = halfFace2->getSurroundingEdges();
 	if(surEdges.size() != 6) halfFace2->mIsTriangle = false;
 
+	if(mLocalValidation) validateAround("createEdge", {halfFace1, halfFace2});
+
 	// printf("\nnewEdge:\n");
 	// edge->print();
 	// printf("newRevEdge:\n");
@@ -944,7 +2170,7 @@ float mesh::Mesh::getHeight() const {
 	float maxY = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curY = mVertices[i]->mCoords->y();
+		float curY = mVertices[i]->mCoords.y();
 		if( curY < minY) minY = curY;
 		if( curY > maxY) maxY = curY;
 	}
@@ -957,7 +2183,7 @@ float mesh::Mesh::getWidth() const {
 	float maxX = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curX = mVertices[i]->mCoords->x();
+		float curX = mVertices[i]->mCoords.x();
 		if( curX < minX) minX = curX;
 		if( curX > maxX) maxX = curX;
 	}
@@ -970,7 +2196,7 @@ float mesh::Mesh::getDepth() const {
 	float maxZ = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curZ = mVertices[i]->mCoords->z();
+		float curZ = mVertices[i]->mCoords.z();
 		if( curZ < minZ) minZ = curZ;
 		if( curZ > maxZ) maxZ = curZ;
 	}
@@ -983,7 +2209,7 @@ float mesh::Mesh::getMinHeight() const{
 	float minY = INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curY = mVertices[i]->mCoords->y();
+		float curY = mVertices[i]->mCoords.y();
 		if( curY < minY) minY = curY;
 	}
 
@@ -994,7 +2220,7 @@ float mesh::Mesh::getMaxHeight() const{
 	float maxY = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curY = mVertices[i]->mCoords->y();
+		float curY = mVertices[i]->mCoords.y();
 		if( curY > maxY) maxY = curY;
 	}
 
@@ -1005,7 +2231,7 @@ float mesh::Mesh::getMinWidth() const{
 	float minX = INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curX = mVertices[i]->mCoords->x();
+		float curX = mVertices[i]->mCoords.x();
 		if( curX < minX) minX = curX;
 	}
 
@@ -1016,7 +2242,7 @@ float mesh::Mesh::getMaxWidth() const{
 	float maxX = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curX = mVertices[i]->mCoords->x();
+		float curX = mVertices[i]->mCoords.x();
 		if( curX > maxX) maxX = curX;
 	}
 
@@ -1027,7 +2253,7 @@ float mesh::Mesh::getMinDepth() const{
 	float minZ = INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curZ = mVertices[i]->mCoords->z();
+		float curZ = mVertices[i]->mCoords.z();
 		if( curZ < minZ) minZ = curZ;
 	}
 
@@ -1038,7 +2264,7 @@ float mesh::Mesh::getMaxDepth() const{
 	float maxZ = -INFINITY;
 
 	for(int i=0; i<mNbVertices; i++){
-		float curZ = mVertices[i]->mCoords->z();
+		float curZ = mVertices[i]->mCoords.z();
 		if( curZ > maxZ) maxZ = curZ;
 	}
 
@@ -1316,27 +2542,31 @@ float mesh::Mesh::getMaxDepth() const{
 // }
 
 void mesh::Mesh::initDiagonals(){
+	// the diagonals are weighted by the S fitmap of their face, only their lengths count without fitmaps
+	const mesh::AttributeChannel<float>* sFitmaps = faceAttributes().find<float>(S_FITMAP);
 	mDiagHeap.clear();
 	for(int i=0; i<mNbFaces; i++){
-		if(!mFaces[i]->mToDelete)
-			mFaces[i]->createDiagonal();
+		if(mFaces[i]->mToDelete) continue;
+		setDiagonal(mFaces[i], sFitmaps ? (*sFitmaps)[i] : 1.0f);
 	}
 	mDiagHeap = mesh::Face::getMinHeap(mFaces);
 	int nbDiags = int(mDiagHeap.size());
 
 	assert( nbDiags == mNbFaces);
 
-	// for(int i=0; i<nbDiags; i++) mDiagHeap[i]->face->print();
+	// for(int i=0; i<nbDiags; i++) mDiagHeap[i].diagonal->face->print();
 }
 
 int mesh::Mesh::diagonalCollapse(){
 	if(mDiagHeap.size() == 0) return EMPTY_HEAP;
-	mesh::Diagonal* diag = mDiagHeap.front();
-	assert(diag != nullptr);
-	std::pop_heap(mDiagHeap.begin(), mDiagHeap.end());
+	mesh::DiagonalEntry entry = mDiagHeap.front();
+	assert(entry.diagonal != nullptr);
+	std::pop_heap(mDiagHeap.begin(), mDiagHeap.end(), mesh::Face::cmpDiagonal);
 	mDiagHeap.pop_back();
 
-	if(diag->face->mToDelete) return NO_UPDATE;
+	// skip the entries left behind by the faces removed, the diagonals dropped and the ones pushed again
+	if(!entry.isCurrent()) return NO_UPDATE;
+	mesh::Diagonal* diag = entry.diagonal;
 
 	// printf("Cur face:\n");
 	// diag->face->print();
@@ -1361,7 +2591,7 @@ int mesh::Mesh::diagonalCollapse(){
 	// for(int i=0; i<int(v1SurFaces.size()); i++) v1SurFaces[i]->print();
 
 	// update old vertex coordinate
-	diag->v1->mCoords = new maths::Vector3((*(diag->v1->mCoords) + *(diag->v2->mCoords)) / 2.0f);
+	diag->v1->mCoords = (diag->v1->mCoords + diag->v2->mCoords) / 2.0f;
 	// printf("\nv1:\n"); diag->v1->print(); diag->v1->mEdge->print();
 	// printf("v2:\n"); diag->v2->print(); diag->v2->mEdge->print();
 	// printf("\n\n");
@@ -1415,6 +2645,9 @@ int mesh::Mesh::diagonalCollapse(){
 	// update old vertices
 	diag->v1->mergeVertices(diag->v2, surEdgesV2);
 
+	// the doublets left by the collapse are checked by their own removals
+	if(mLocalValidation) validateAround("diagonalCollapse", toUpdate);
+
 	// printf("\nSurFaces:\n");
 	// for(int i=0; i<int(surFaces.size()); i++) {
 	// 	printf("i: %d\n", i); surFaces[i]->print();
@@ -1492,73 +2725,113 @@ void mesh::Mesh::removeEdgeV2(mesh::Edge* edge){
 	edge->mToDelete = true;
 	edge->mReverseEdge->mToDelete = true;
 
+	if(mLocalValidation) validateAround("removeEdgeV2", {rightFace});
+
 	// removeDoublets(rightFace->getSurroundingFaces());
 	
 	// removeEdgeFromList(edge);
 }
 
-void mesh::Mesh::removeEdgesFromList(){
-	int i=0;
-	while(i<mNbEdges){
-		mesh::Edge* curEdge = mEdges[i];
-		if(curEdge->mToDelete){
-			mEdges.erase(mEdges.begin()+i);
-			mNbEdges--;
+namespace{
+
+/**
+ * Remove the flagged elements of a list in one pass, keeping the order of the others
+ * @param list The list
+ * @param attributes The channels of the list, compacted the same way
+ * @param map Filled with the new index of each old index, -1 for the removed elements
+ * @param remove Called on each removed element
+*/
+template<typename T, typename Remove>
+void compactList(std::vector<T*> & list, mesh::AttributeSet & attributes, std::vector<int> & map, Remove remove){
+	map.resize(list.size());
+	int nbKept = 0;
+	for(int i=0; i<int(list.size()); i++){
+		T* cur = list[i];
+		if(cur->mToDelete){
+			map[i] = -1;
+			remove(cur);
 			continue;
 		}
-		i++;
+		map[i] = nbKept;
+		cur->mSlot = nbKept;
+		list[nbKept++] = cur;
 	}
+	list.resize(nbKept);
+	attributes.compact(map, nbKept);
+}
+
+}
+
+void mesh::Mesh::removeEdgesFromList(){
+	compactList(mEdges, mStorage->edgeAttributes, mCompaction.edges,
+		[this](mesh::Edge* edge){ deleteEdge(edge); });
+	mNbEdges = int(mEdges.size());
 }
 
 void mesh::Mesh::removeFacesFromList(){
-	int i=0;
-	while(i<mNbFaces){
-		mesh::Face* curFace = mFaces[i];
-		if(curFace->mToDelete){
-			mFaces.erase(mFaces.begin()+i);
-			mNbFaces--;
-			continue;
-		}
-		i++;
-	}
+	compactList(mFaces, mStorage->faceAttributes, mCompaction.faces,
+		[this](mesh::Face* face){ deleteFace(face); });
+	mNbFaces = int(mFaces.size());
 }
 
 void mesh::Mesh::removeVerticesFromList(){
-	int i=0;
-	int nbVerticesDeleted = 0;
-	while(i<mNbVertices){
-		mesh::Vertex* curVertex = mVertices[i];
-		if(curVertex->mToDelete){
-			nbVerticesDeleted++;
-			mVertices.erase(mVertices.begin()+i);
-			mNbVertices--;
-			continue;
-		}
-		// update vertex index
-		curVertex->mId -= nbVerticesDeleted;
-		i++;
-	}
+	compactList(mVertices, mStorage->vertexAttributes, mCompaction.vertices,
+		[this](mesh::Vertex* vertex){ deleteVertex(vertex); });
+	mNbVertices = int(mVertices.size());
+}
+
+void mesh::Mesh::removeDeletedDiagonals(){
+	size_t nbDiags = mDiagHeap.size();
+	mDiagHeap.erase(std::remove_if(mDiagHeap.begin(), mDiagHeap.end(), 
+		[](const mesh::DiagonalEntry & entry){ return !entry.isCurrent(); }), mDiagHeap.end());
+	if(mDiagHeap.size() != nbDiags) std::make_heap(mDiagHeap.begin(), mDiagHeap.end(), mesh::Face::cmpDiagonal);
+
+	// the heap does not point at the dropped diagonals anymore
+	for(mesh::Diagonal* diag : mStorage->droppedDiagonals) mStorage->diagonals.destroy(diag);
+	mStorage->droppedDiagonals.clear();
 }
 
-void mesh::Mesh::clean(){
+const mesh::Mesh::CompactionMap & mesh::Mesh::clean(){
+	// the removed faces are destroyed, so the heap must not reach them anymore
+	removeDeletedDiagonals();
 	removeEdgesFromList();
 	removeFacesFromList();
 	removeVerticesFromList();
+
+	return mCompaction;
+}
+
+const mesh::Mesh::CompactionMap & mesh::Mesh::getLastCompaction() const{
+	return mCompaction;
+}
+
+void mesh::Mesh::indexSlots(){
+	for(int i=0; i<int(mVertices.size()); i++) mVertices[i]->mSlot = i;
+	for(int i=0; i<int(mFaces.size()); i++) mFaces[i]->mSlot = i;
+	for(int i=0; i<int(mEdges.size()); i++) mEdges[i]->mSlot = i;
+	mStorage->vertexAttributes.resize(mVertices.size());
+	mStorage->faceAttributes.resize(mFaces.size());
+	mStorage->edgeAttributes.resize(mEdges.size());
 }
 
 void mesh::Mesh::updateDiagonals(std::vector<mesh::Face*> toUpdate){
+	const mesh::AttributeChannel<float>* sFitmaps = faceAttributes().find<float>(S_FITMAP);
 	for(int i=0; i<int(toUpdate.size()); i++){
 		// printf("Update diagonals: %d/%d\n", i, int(toUpdate.size()));
-		if(toUpdate[i]->mToDelete) continue;
-		toUpdate[i]->createDiagonal();
+		mesh::Face* face = toUpdate[i];
+		if(face->mToDelete) continue;
+		mesh::Diagonal* diag = face->mDiagonal;
+		setDiagonal(face, sFitmaps ? (*sFitmaps)[face->mSlot] : 1.0f);
+
+		// a new diagonal or a diagonal whose priority changed gets a new entry, its old one becomes stale
+		mesh::Diagonal* newDiag = face->mDiagonal;
+		if(newDiag && (newDiag != diag || newDiag->weightedLength() != newDiag->priority)) pushDiagonal(newDiag);
 	}
 }
 
 
 void mesh::Mesh::removeDoublet(mesh::Edge* e1, mesh::Edge* e2){
-	std::vector<mesh::Edge*> surEdge = e1->mVertexDestination->getSurroundingEdges();
-	// for(int i=0; i<int(surEdge.size()); i++) {surEdge[i]->print(); surEdge[i]->mFaceRight->print();}
-	assert(surEdge.size() == 4);
+	assert(mesh::vertexEdges(e1->mVertexDestination).size() == 2);
 
 	// update edges arround f1
 	e1->mFaceRight->mergeFace(e1->mFaceLeft);
@@ -1593,6 +2866,8 @@ void mesh::Mesh::removeDoublet(mesh::Edge* e1, mesh::Edge* e2){
 
 	// remove vertex
 	e1->mVertexDestination->mToDelete = true;
+
+	if(mLocalValidation) validateAround("removeDoublet", {e1->mFaceRight});
 }
 
 
@@ -1659,17 +2934,15 @@ void mesh::Mesh::removeDoublets(std::vector<mesh::Face*> faces){
 void mesh::Mesh::removeSinglet(mesh::Face* face){
 	// printf("\nSinglet removal:\n");
 	// face->print();
-	std::vector<mesh::Edge*> surEdges = face->getSurroundingEdges(face->mEdge);
+	std::vector<mesh::Face*> surFaces;
+	if(mLocalValidation) surFaces = face->getAllSurroundingFaces();
 	mesh::Edge* edge = nullptr;
-	for(int i=0; i<int(surEdges.size()); i++){
-		mesh::Edge* curEdge = surEdges[i];
+	for(mesh::Edge* curEdge : mesh::faceEdges(face)){
 		// printf("\nCur edge:\n"); curEdge->print(); curEdge->mReverseEdge->print(); curEdge->mFaceLeft->print();
 		assert(!curEdge->mFaceLeft->mToDelete);
-		int nbEdges = curEdge->mEdgeRightCCW->mVertexOrigin->getSurroundingEdges().size();
-		// printf("Cur vertex:\n");
-		// curEdge->mEdgeRightCCW->mVertexOrigin->print();
-		// printf("Nb edges:%d\n", nbEdges);
-		if( nbEdges == 2){
+		// a vertex with a single outgoing edge is inside the singlet
+		int nbEdges = mesh::vertexEdges(curEdge->mEdgeRightCCW->mVertexOrigin).size();
+		if( nbEdges == 1){
 			edge = curEdge;
 			break;
 		}
@@ -1741,14 +3014,15 @@ void mesh::Mesh::removeSinglet(mesh::Face* face){
 		edge->mReverseEdge->mEdgeLeftCCW = nextEdge->mEdgeLeftCCW;
 		edge->mReverseEdge->mEdgeLeftCW = nextEdge->mEdgeLeftCW;
 
+		if(mLocalValidation) validateAround("removeSinglet", surFaces);
 		return;
 	}
 
 	// singlet facing outside
 	// printf("\nSinglet removal Outside\n");
 	// get correct edge
-	for(int i=0; i<=int(surEdges.size()); i++){
-		edge = surEdges[i];
+	for(mesh::Edge* curEdge : mesh::faceEdges(face)){
+		edge = curEdge;
 		if(edge->mVertexDestination->mId == edge->mEdgeRightCW->mEdgeRightCW->mVertexDestination->mId) break;
 	}
 	// printf("Edge to edit before:\n"); edge->print(); edge->mEdgeRightCW->print();
@@ -1761,99 +3035,95 @@ void mesh::Mesh::removeSinglet(mesh::Face* face){
 	// printf("Edge to edit after:\n"); edge->print(); edge->mEdgeRightCW->print();
 	// printf("Faces to edit after:\n"); edge->mFaceRight->print(); edge->mEdgeRightCW->mFaceRight->print();
 
+	if(mLocalValidation) validateAround("removeSinglet", surFaces);
+
 }
 
 
-std::vector<std::vector<mesh::Vertex*>> mesh::Mesh::initNeighbourhood(mesh::Vertex* v) const{
+void mesh::Mesh::initNeighbourhoodGraph(const mesh::AttributeChannel<maths::Vector3> & faceNormals, NeighbourhoodGraph & graph) const{
+	graph.coords.resize(mNbVertices);
+	graph.neighbourOffsets.assign(1, 0);
+	graph.neighbours.clear();
+	graph.faceOffsets.assign(1, 0);
+	graph.faceNormals.clear();
+	for(int i=0; i<mNbVertices; i++){
+		const mesh::Vertex* v = mVertices[i];
+		graph.coords[i] = v->mCoords;
+		for(const mesh::Vertex* neighbour : v->mNeighbours) graph.neighbours.push_back(neighbour->mSlot);
+		graph.neighbourOffsets.push_back(graph.neighbours.size());
+		for(const mesh::Face* face : v->mNeighboursFaces) graph.faceNormals.push_back(faceNormals[face->mSlot]);
+		graph.faceOffsets.push_back(graph.faceNormals.size());
+	}
+}
+
+void mesh::Mesh::initNeighbourhood(int v, const NeighbourhoodGraph & graph, std::vector<std::vector<int>> & neighbours) const{
 	int nbRadii = mRadii.size();
-	std::vector<std::vector<mesh::Vertex*>> neighbours(nbRadii);
+	neighbours.resize(nbRadii);
+	for(std::vector<int> & bpi : neighbours) bpi.clear();
+
+	// a vertex is reached by this search when it is stamped with its generation, so the stamps are never cleared
+	if(int(mVisits.size()) < mNbVertices) mVisits.resize(mNbVertices, 0);
+	if(++mVisitGeneration == 0){
+		std::fill(mVisits.begin(), mVisits.end(), 0);
+		mVisitGeneration = 1;
+	}
+	const uint32_t generation = mVisitGeneration;
 
-	const int VISITED = 1;
-	const int ONGOING = 2;
+	mVisits[v] = generation;
 
-	// initiate a dictionary containing the vertex's id as keys and the state of each vertices (unvisited, ongoing or visited) as values
-	int status[mNbVertices];
+	// the largest radius, the radii shrink when the bounding box is small against the edges
+	float maxRadius = *std::max_element(mRadii.begin(), mRadii.end());
 
-	status[v->mId] = ONGOING;
+	// initiate the queue for the BFS search, the vertices stay in it so it is reused without allocations
+	std::vector<int> & queue = mVisitQueue;
+	queue.clear();
+	queue.push_back(v);
 
-	// initiate the queue for the BFS search
-	std::queue<mesh::Vertex*> queue;
-	queue.push(v);
+	// the loop only goes through plain arrays, so nothing is reloaded after the pushes
+	uint32_t* visits = mVisits.data();
+	const float* radii = mRadii.data();
+	const int* offsets = graph.neighbourOffsets.data();
+	const int* adjacency = graph.neighbours.data();
+	const maths::Vector3* coords = graph.coords.data();
+	const maths::Vector3 center = coords[v];
 
-	while(!queue.empty()){
-		// remove current vertex from queue
-		mesh::Vertex* curVertex = queue.front();
-		queue.pop();
+	// the search stops once MAX_NEIGHBOURHOOD vertices are reached, the closest rings are visited first
+	// so the larger radii keep the vertices around v and the cost of a search no longer grows with the mesh
+	const int maxSize = MAX_NEIGHBOURHOOD + 1;
 
-		// for each neighbours
-		std::vector<mesh::Vertex*> curNeighbours = curVertex->mNeighbours;
-		// printf("\nnbNeighbours: %d\n", int(neighbours.size()));
-		for(int i=0; i<int(curNeighbours.size()); i++){
-			mesh::Vertex* curNeighbourVertex = curNeighbours[i];
+	for(int next=0; next<int(queue.size()) && int(queue.size())<maxSize; next++){
+		int curVertex = queue[next];
 
-			if(status[curNeighbourVertex->mId] == ONGOING || status[curNeighbourVertex->mId] == VISITED) continue;
-			bool toVisit = false;
+		// for each neighbours
+		for(int k=offsets[curVertex]; k<offsets[curVertex+1] && int(queue.size())<maxSize; k++){
+			int curNeighbourVertex = adjacency[k];
+			if(visits[curNeighbourVertex] == generation) continue;
+			visits[curNeighbourVertex] = generation;
 
 			// get the distance between the vertices
-			float dist = maths::Vector3::distance(v->mCoords, curNeighbourVertex->mCoords);
+			float dist = maths::Vector3::distance(center, coords[curNeighbourVertex]);
 			assert(dist>=0.0f);
 
-			// push the vertex in the array if in radii
+			// push the vertex in the array if in radii and visit it
+			if(!(dist<maxRadius)) continue;
 			for(int j=0; j<nbRadii; j++){
-				if(dist<mRadii[j]){
-					neighbours[j].push_back(curNeighbourVertex);
-					toVisit = true;
-				}
-			}
-
-			// if current vertex not visited yet add it to the queue
-			status[curNeighbourVertex->mId] = ONGOING;
-			if(toVisit){
-				queue.push(curNeighbourVertex);
+				if(dist<radii[j]) neighbours[j].push_back(curNeighbourVertex);
 			}
+			queue.push_back(curNeighbourVertex);
 		}
-
-		// done visiting the current vertex
-		status[curVertex->mId] = VISITED;
 	}
-
-
-	// // naive O(n2) implementation
-	// for(int i=0; i<mNbVertices; i++){
-	// 	mesh::Vertex* curVertex = mVertices[i];
-	// 	if(curVertex->mId == v->mId) continue;
-
-	// 	// get the distance between the verties
-	// 	float dist = maths::Vector3::distance(v->mCoords, curVertex->mCoords);
-
-	// 	// push the vertex in the array if in radii
-	// 	for(int j=0; j<nbRadii; j++){
-	// 		if(dist<mRadii[j]) neighbours[j].push_back(curVertex);
-	// 	}
-	// }
-
-	return neighbours;
 }
 
 
-float mesh::Mesh::getFittingError(std::vector<mesh::Vertex*> bpi, maths::Vector3 plane) const {
-	float sum = 0.0f;
+float mesh::Mesh::getFittingError(const std::vector<maths::Vector3> & bpi, const maths::Vector3 & plane) const {
 	int bpiSize = int(bpi.size());
 
 	int a = plane.x();
 	int b = plane.y();
 	int c = plane.z();
 
-	for(int i=0; i<bpiSize; i++){
-		maths::Vector3* coords = bpi[i]->mCoords;
-
-		float realZ = coords->z();
-		float estiZ = a*coords->x() + b*coords->y() + c;
-
-		sum += (realZ-estiZ) * (realZ-estiZ);
-	}
-
-	return (bpiSize==0) ? 0.0f : ((1.0f)/bpiSize) * sqrtf(sum);
+	float dist = maths::Vector3Batch::verticalDistance(bpi.data(), bpiSize, float(a), float(b), float(c));
+	return (bpiSize==0) ? 0.0f : ((1.0f)/bpiSize) * dist;
 }
 
 float mesh::Mesh::getQuadraticFittingErrors(std::vector<float> errors) const{
@@ -1869,42 +3139,47 @@ float mesh::Mesh::getQuadraticFittingErrors(std::vector<float> errors) const{
 	return sum;
 }
 
-int mesh::Mesh::getNbInconsistentlyOriented(maths::Vector3* n, std::vector<mesh::Face*> bpiFace){
-	int bpiSize = int(bpiFace.size());
-
-	int nbFaces = 0;
-
-	// for each faces get the dot product between n and the normal of the face
-	for(int i=0; i<bpiSize; i++){
-		float dot = maths::Vector3::dot(bpiFace[i]->mNormal, n);
-		// if positive increase the sum
-		if(dot>0) nbFaces++;
-	}
-
-	return nbFaces;
-}
-
-std::vector<std::vector<mesh::Face*>> mesh::Mesh::initNeighbourhoodFaces(std::vector<std::vector<mesh::Vertex*>> bpis){
+void mesh::Mesh::getConsistentlyOriented(const std::vector<maths::Vector3> & n, const std::vector<std::vector<int>> & bpis,
+		const NeighbourhoodGraph & graph, std::vector<char> & consistent) const{
 	int nbRadii = mRadii.size();
-	std::vector<std::vector<mesh::Face*>> faces(nbRadii);
+	std::vector<int> nbInconsistentlyOriented(nbRadii, 0);
+
+	// a neighbourhood stays consistent while the ratio of its inconsistently oriented faces is below the tolerance,
+	// the ratio only grows so the faces stop being counted once no neighbourhood is consistent anymore
+	consistent.assign(nbRadii, false);
+	int nbConsistent = 0;
+	for(int j=0; j<nbRadii; j++){
+		float ratio = 0.0f / float(bpis[j].size());
+		consistent[j] = ratio <= THO_FITMAP;
+		nbConsistent += consistent[j];
+	}
 
-	std::vector<mesh::Vertex*> bph = bpis[nbRadii-1];
+	const std::vector<int> & bph = bpis[nbRadii-1];
 
+	// the faces of a neighbourhood are the ones around the first vertices of the last one
 	int i=0; int curMinRadii = 0;
-	while(i<int(bph.size())){
-		mesh::Vertex* curVertex = bph[i];
-		std::vector<mesh::Face*> surFaces = curVertex->mNeighboursFaces;
+	while(i<int(bph.size()) && nbConsistent>0){
+		int curVertex = bph[i];
 
 		if(i>=int(bpis[curMinRadii].size())) curMinRadii++;
 
+		// for each faces get the dot product between n and the normal of the face and count the positive ones
+		const maths::Vector3* faceNormals = graph.faceNormals.data() + graph.faceOffsets[curVertex];
+		int nbFaces = graph.faceOffsets[curVertex+1] - graph.faceOffsets[curVertex];
 		for(int j=curMinRadii; j<nbRadii; j++){
-			faces[j].insert(faces[j].end(), surFaces.begin(), surFaces.end());
+			if(!consistent[j]) continue;
+			nbInconsistentlyOriented[j] += maths::Vector3Batch::countPositiveDots(n[j], faceNormals, nbFaces);
+
+			// check if ratio greater than tolerance
+			float ratio = float(nbInconsistentlyOriented[j]) / float(bpis[j].size());
+			if( ratio > THO_FITMAP ){
+				consistent[j] = false;
+				nbConsistent--;
+			}
 		}
 
 		i++;
 	}
-
-	return faces;
 }
 
 
@@ -1913,99 +3188,213 @@ void mesh::Mesh::buildVerticesFitmaps(){
 	float maxSMap = -INFINITY;
 	float maxMMap = -INFINITY;
 
-	// for each vertex p
-	for(int i=0; i<mNbVertices; i++){
-		mesh::Vertex* p = mVertices[i];
+	// the only channels the pass goes through
+	mesh::AttributeChannel<float> & sFitmaps = vertexAttributes().attach<float>(S_FITMAP);
+	mesh::AttributeChannel<float> & mFitmaps = vertexAttributes().attach<float>(M_FITMAP);
+	const mesh::AttributeChannel<maths::Vector3> & faceNormals = faceAttributes().attach<maths::Vector3>(NORMAL);
 
-		// create the neighbourhoods
-		// auto start = std::chrono::high_resolution_clock::now();
-		std::vector<std::vector<mesh::Vertex*>> bpis = initNeighbourhood(p);
-		std::vector<std::vector<mesh::Face*>> bpisFaces = initNeighbourhoodFaces(bpis);
-		// auto stop = std::chrono::high_resolution_clock::now();
-		// auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    	// printf("init neighbourhood: %f\n", double(duration.count()));
+	// the searches go through flat copies of the coordinates, the neighbours and the faces' normals
+	NeighbourhoodGraph graph;
+	initNeighbourhoodGraph(faceNormals, graph);
 
-		// the fitting errors
-		std::vector<float> errors;
+	// buffers reused by all the neighbourhoods
+	int nbRadii = mRadii.size();
+	std::vector<std::vector<int>> bpis;
+	std::vector<maths::Vector3> points;
+	std::vector<maths::Vector3> normals(nbRadii);
+	std::vector<char> consistent;
+	std::vector<float> errors(nbRadii);
 
-		// float largest radii for mMap calculation
-		float largestRadii = mRadii[0];
+	// for each vertex p
+	for(int i=0; i<mNbVertices; i++){
+		// create the neighbourhoods
+		initNeighbourhood(i, graph, bpis);
 
 		// for each radii neighbourhood
-		for(int j=0; j<int(bpis.size()); j++){
-			std::vector<mesh::Vertex*> bpi = bpis[j];
-			std::vector<mesh::Face*> bpiFace = bpisFaces[j];
+		for(int j=0; j<nbRadii; j++){
+			const std::vector<int> & bpi = bpis[j];
 			int bpiSize = bpi.size();
+
+			// gather the coordinates for the batch kernels
+			points.clear();
+			for(int k=0; k<bpiSize; k++) points.push_back(graph.coords[bpi[k]]);
 			
 			// get the fitting plane using OLS
-			maths::Vector3* interpolatedPlane = mesh::Vertex::getInterpolatedPlane(bpi);
+			maths::Vector3 interpolatedPlane = maths::Vector3Batch::fitPlane(points.data(), bpiSize);
 
 			// mMap
-			float a = interpolatedPlane->x(); float b = interpolatedPlane->y();	float c = interpolatedPlane->z();
+			float a = interpolatedPlane.x(); float b = interpolatedPlane.y();	float c = interpolatedPlane.z();
 			maths::Vector3 p1(0.0f,0.0f,c); maths::Vector3 p2(1.0f,0.0f,a+c); maths::Vector3 p3(0.0f,1.0f,b+c);
 			// get the normal of the plane
-			maths::Vector3* n = maths::Vector3::getNormalOfPlane(p1, p2, p3);
-			
-			// auto start = std::chrono::high_resolution_clock::now();
-			// get the number of consistently oriented faces
-			int nbInconsistentlyOriented = getNbInconsistentlyOriented(n, bpiFace);
-			// auto stop = std::chrono::high_resolution_clock::now();
-			// auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-			// printf("get consistently oriented: %f\n", double(duration.count()));
-			
-			// check if ratio greater than tolerance
-			float ratio = bpiSize >=0 ? float(nbInconsistentlyOriented) / float(bpiSize) : 0.0f;
-			if( ratio <= THO_FITMAP ) largestRadii = mRadii[j];
+			normals[j] = maths::Vector3::getNormalOfPlane(p1, p2, p3);
 
 			// back to sMap
 			// get the fitting error
-			float Eri = getFittingError(bpi, interpolatedPlane);
-			errors.push_back(Eri);
+			errors[j] = getFittingError(points, interpolatedPlane);
+		}
+
+		// get the neighbourhoods with consistently oriented faces
+		getConsistentlyOriented(normals, bpis, graph, consistent);
+
+		// float largest radii for mMap calculation
+		float largestRadii = mRadii[0];
+		for(int j=0; j<nbRadii; j++){
+			if(consistent[j]) largestRadii = mRadii[j];
 		}
 
 		// get the quadratic error regression
 		float a = getQuadraticFittingErrors(errors);
 		// assign the sMap
-		p->mSFitmap = sqrtf(a);
+		sFitmaps[i] = sqrtf(a);
 		// assign the mMap
-		p->mMFitmap = largestRadii;
+		mFitmaps[i] = largestRadii;
 
 		// update max
-		if(p->mSFitmap > maxSMap) maxSMap = p->mSFitmap;
-		if(p->mMFitmap > maxMMap) maxMMap = p->mMFitmap;
+		if(sFitmaps[i] > maxSMap) maxSMap = sFitmaps[i];
+		if(mFitmaps[i] > maxMMap) maxMMap = mFitmaps[i];
 		
 	}
 	// normalize fitmaps
 	for(int i=0; i<mNbVertices; i++){
 		// printf("\n\nMaxMMap: %f, MaxSMap: %f\n", maxMMap, maxSMap);
-		mesh::Vertex* p = mVertices[i];
-		// printf("MMap before: %f\n", p->mMFitmap);
-		// printf("SMap before: %f\n", p->mSFitmap);
+		// printf("MMap before: %f\n", mFitmaps[i]);
+		// printf("SMap before: %f\n", sFitmaps[i]);
 		if(maxSMap)
-			p->mSFitmap /= maxSMap;
+			sFitmaps[i] /= maxSMap;
 		if(maxMMap)
-			p->mMFitmap /= maxMMap;
-		// printf("MMap after: %f\n", p->mMFitmap);
-		// printf("SMap after: %f\n\n", p->mSFitmap);
+			mFitmaps[i] /= maxMMap;
+		// printf("MMap after: %f\n", mFitmaps[i]);
+		// printf("SMap after: %f\n\n", sFitmaps[i]);
 	}
 }
 
 void mesh::Mesh::buildFacesFitmaps(){
+	const mesh::AttributeChannel<float> & vertexSFitmaps = vertexAttributes().attach<float>(S_FITMAP);
+	const mesh::AttributeChannel<float> & vertexMFitmaps = vertexAttributes().attach<float>(M_FITMAP);
+	mesh::AttributeChannel<float> & sFitmaps = faceAttributes().attach<float>(S_FITMAP);
+	mesh::AttributeChannel<float> & mFitmaps = faceAttributes().attach<float>(M_FITMAP);
+
 	// for each faces f
 	for(int i=0; i<mNbFaces; i++){
 		mesh::Face* f = mFaces[i];
 		// get interpolated values
-		std::vector<mesh::Vertex*> surVertices = f->getSurroundingVertices();
 		float sumSMap = 0.0f;
 		float sumMMap = 0.0f;
-		for(int j=0; j<int(surVertices.size()); j++){
-			sumSMap += surVertices[j]->mSFitmap;
-			sumMMap += surVertices[j]->mMFitmap;
+		int nbVertices = 0;
+		mesh::Circulator<mesh::FaceVertexStep> ring = mesh::faceVertices(f);
+		for(auto it = ring.begin(); it != ring.end(); ++it){
+			// a vertex is counted once like in getSurroundingVertices
+			bool alreadySeen = false;
+			for(auto prev = ring.begin(); prev != it && !alreadySeen; ++prev) alreadySeen = *prev == *it;
+			if(alreadySeen) continue;
+			sumSMap += vertexSFitmaps[(*it)->mSlot];
+			sumMMap += vertexMFitmaps[(*it)->mSlot];
+			nbVertices++;
 		}
 
-		f->mSFitmap = sumSMap / float(surVertices.size());
-		f->mMFitmap = sumMMap / float(surVertices.size());
+		sFitmaps[i] = sumSMap / float(nbVertices);
+		mFitmaps[i] = sumMMap / float(nbVertices);
+	}
+}
+
+namespace{
+
+/**
+ * The header of a fitmap cache file, followed by the radii,
+ * the vertices' S and M fitmaps and the faces' S and M fitmaps (floats)
+*/
+struct FitmapsHeader{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	int32_t nbVertices;
+	int32_t nbFaces;
+	int32_t nbRadii;
+	int32_t padding;
+};
+
+}
+
+uint64_t mesh::Mesh::fitmapsKey(const mesh::RawMesh &raw){
+	uint64_t key = utils::hashBytes(raw.coords.data(), raw.coords.size()*sizeof(float));
+	key = utils::hashBytes(raw.indices.data(), raw.indices.size()*sizeof(int), key);
+	key = utils::hashBytes(raw.offsets.data(), raw.offsets.size()*sizeof(int), key);
+	key = utils::hashBytes(&H_FITMAP, sizeof(H_FITMAP), key);
+	key = utils::hashBytes(&THO_FITMAP, sizeof(THO_FITMAP), key);
+	key = utils::hashBytes(&MAX_NEIGHBOURHOOD, sizeof(MAX_NEIGHBOURHOOD), key);
+	return key;
+}
+
+std::string mesh::Mesh::fitmapsCacheFile(std::string file, uint64_t key, std::string dir){
+	if (dir.empty()) return file + ".fitmaps";
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.fitmaps", (unsigned long long)key);
+	return dir + "/" + name;
+}
+
+bool mesh::Mesh::loadFitmaps(std::string file, uint64_t key){
+	std::ifstream cacheFile(file, std::ios::binary);
+	if (!cacheFile) return false;
+
+	FitmapsHeader header;
+	if (!cacheFile.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+	if (header.magic != FITMAPS_MAGIC || header.version != FITMAPS_VERSION || header.key != key
+		|| header.nbVertices != mNbVertices || header.nbFaces != mNbFaces || header.nbRadii != H_FITMAP+1){
+		return false;
+	}
+
+	std::vector<float> radii(header.nbRadii);
+	std::vector<float> fitmaps(2*mNbVertices + 2*mNbFaces);
+	cacheFile.read(reinterpret_cast<char*>(radii.data()), radii.size()*sizeof(float));
+	cacheFile.read(reinterpret_cast<char*>(fitmaps.data()), fitmaps.size()*sizeof(float));
+	if (!cacheFile) return false;
+
+	// the channels are indexed like the lists
+	mRadii = radii;
+	const float* cur = fitmaps.data();
+	std::copy(cur, cur + mNbVertices, vertexAttributes().attach<float>(S_FITMAP).data());
+	cur += mNbVertices;
+	std::copy(cur, cur + mNbVertices, vertexAttributes().attach<float>(M_FITMAP).data());
+	cur += mNbVertices;
+	std::copy(cur, cur + mNbFaces, faceAttributes().attach<float>(S_FITMAP).data());
+	cur += mNbFaces;
+	std::copy(cur, cur + mNbFaces, faceAttributes().attach<float>(M_FITMAP).data());
+	return true;
+}
+
+bool mesh::Mesh::saveFitmaps(std::string file, uint64_t key) const {
+	FitmapsHeader header = {FITMAPS_MAGIC, FITMAPS_VERSION, key, mNbVertices, mNbFaces, int32_t(mRadii.size()), 0};
+
+	// the channels are indexed like the lists
+	const mesh::AttributeChannel<float>* channels[4] = {
+		vertexAttributes().find<float>(S_FITMAP), vertexAttributes().find<float>(M_FITMAP),
+		faceAttributes().find<float>(S_FITMAP), faceAttributes().find<float>(M_FITMAP)
+	};
+	for(const mesh::AttributeChannel<float>* channel : channels) if (!channel) return false;
+	std::vector<float> fitmaps;
+	fitmaps.reserve(2*mNbVertices + 2*mNbFaces);
+	fitmaps.insert(fitmaps.end(), channels[0]->data(), channels[0]->data() + mNbVertices);
+	fitmaps.insert(fitmaps.end(), channels[1]->data(), channels[1]->data() + mNbVertices);
+	fitmaps.insert(fitmaps.end(), channels[2]->data(), channels[2]->data() + mNbFaces);
+	fitmaps.insert(fitmaps.end(), channels[3]->data(), channels[3]->data() + mNbFaces);
+
+	// write next to the cache file and rename, so a concurrent load never sees a partial file,
+	// the temporary name is unique to the process and the thread so concurrent writers never share it
+	char suffix[64];
+	std::snprintf(suffix, sizeof(suffix), ".%ld.%zx.tmp", long(getpid()), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	std::string tmpFile = file + suffix;
+	std::ofstream cacheFile(tmpFile, std::ios::binary);
+	if (!cacheFile) return false;
+	cacheFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeArray(cacheFile, mRadii);
+	writeArray(cacheFile, fitmaps);
+	cacheFile.close();
+	if (!cacheFile || std::rename(tmpFile.c_str(), file.c_str()) != 0){
+		std::remove(tmpFile.c_str());
+		return false;
 	}
+	return true;
 }
 
 void mesh::Mesh::buildFitmaps(){
@@ -2,11 +2,17 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
 
 #include "face.hpp"
 #include "vertex.hpp"
 #include "edge.hpp"
 #include "vector3.hpp"
+#include "rawMesh.hpp"
+#include "loadOptions.hpp"
+#include "elementPool.hpp"
+#include "attributes.hpp"
 
 namespace mesh{
 
@@ -30,7 +36,52 @@ class Mesh{
         */
         static float THO_FITMAP;
 
+        /**
+         * Maximum number of vertices reached by the neighbourhood search of a vertex's fitmaps
+        */
+        static int MAX_NEIGHBOURHOOD;
+
+        /**
+         * Magic number of the binary snapshots
+        */
+        static constexpr uint32_t BINARY_MAGIC = 0x424d5141; // "AQMB"
+
+        /**
+         * Version of the binary snapshots
+        */
+        static constexpr uint32_t BINARY_VERSION = 1;
+
+        /**
+         * Magic number of the fitmap cache files
+        */
+        static constexpr uint32_t FITMAPS_MAGIC = 0x464d5141; // "AQMF"
+
+        /**
+         * Version of the fitmap cache files, bumped when the fitmaps they hold change
+        */
+        static constexpr uint32_t FITMAPS_VERSION = 2;
+
+        /**
+         * Name of the edge channel scoring the candidates of triToQuad
+        */
+        static constexpr const char* SUM_DOT_PROD = "sumDotProd";
+
     public:
+        /**
+         * Name of the vertex and face channels of the S fitmaps
+        */
+        static constexpr const char* S_FITMAP = "sFitmap";
+
+        /**
+         * Name of the vertex and face channels of the M fitmaps
+        */
+        static constexpr const char* M_FITMAP = "mFitmap";
+
+        /**
+         * Name of the face channel of the normals computed at load
+        */
+        static constexpr const char* NORMAL = "normal";
+
         /**
          *  The number of vertices in the mesh
         */
@@ -62,9 +113,9 @@ class Mesh{
         std::vector<mesh::Edge*> mEdges;
 
         /**
-         * A heap of diagonals
+         * A heap of diagonals, with stale entries left by the diagonals pushed again
         */
-        std::vector<mesh::Diagonal*> mDiagHeap;
+        std::vector<mesh::DiagonalEntry> mDiagHeap;
 
         /**
          * The index of the first triangle
@@ -76,6 +127,89 @@ class Mesh{
         */
         std::vector<float> mRadii;
 
+    private:
+        /**
+         * The coordinates, the neighbours and the normals of the surrounding faces of the vertices,
+         * flattened and indexed by the vertices' slots for the neighbourhood searches of the fitmaps
+        */
+        struct NeighbourhoodGraph{
+            std::vector<maths::Vector3> coords;
+            std::vector<int> neighbourOffsets;
+            std::vector<int> neighbours;
+            std::vector<int> faceOffsets;
+            std::vector<maths::Vector3> faceNormals;
+        };
+
+        /**
+         * The generation of the last initNeighbourhood search that reached each vertex, indexed by the vertices' slots
+        */
+        mutable std::vector<uint32_t> mVisits;
+
+        /**
+         * The generation of the current initNeighbourhood search
+        */
+        mutable uint32_t mVisitGeneration = 0;
+
+        /**
+         * The vertices reached by the current initNeighbourhood search, in the order they are visited
+        */
+        mutable std::vector<int> mVisitQueue;
+
+        /**
+         * The storage of the mesh's elements, each kind in its own pool with its own id counter
+         * and its attribute channels indexed by the slots, so meshes can be built and edited at the same time
+        */
+        struct Storage{
+            mesh::ElementPool<mesh::Vertex> vertices;
+            mesh::ElementPool<mesh::Face> faces;
+            mesh::ElementPool<mesh::Edge> edges;
+            mesh::ElementPool<mesh::Diagonal> diagonals;
+            std::vector<mesh::Diagonal*> droppedDiagonals;
+            int nextVertexId = 0;
+            int nextFaceId = 0;
+            int nextEdgeId = 0;
+            mesh::AttributeSet vertexAttributes;
+            mesh::AttributeSet faceAttributes;
+            mesh::AttributeSet edgeAttributes;
+        };
+
+        /**
+         * The mesh's elements, shared by the copies of the mesh
+        */
+        std::shared_ptr<Storage> mStorage = std::make_shared<Storage>();
+
+    public:
+        /**
+         * The new indices in the lists of the elements kept by a clean, -1 for the removed ones,
+         * indexed by their old indices
+        */
+        struct CompactionMap{
+            std::vector<int> vertices;
+            std::vector<int> faces;
+            std::vector<int> edges;
+        };
+
+    private:
+        /**
+         * The indices remapping of the last clean
+        */
+        CompactionMap mCompaction;
+
+        /**
+         * Tells if the elements are reordered for cache locality at the end of triToQuad
+        */
+        bool mReorder = false;
+
+        /**
+         * Tells if the one-ring of every topological operation is checked right after it, to debug the collapses
+        */
+        bool mLocalValidation = false;
+
+        /**
+         * Tells if triToQuad pairs the triangles with a parallel maximal matching instead of the greedy pass
+        */
+        bool mParallelPairing = false;
+
     public:
 
         /**
@@ -97,6 +231,7 @@ class Mesh{
             mVertices = vertices;
             mFaces = faces;
             mEdges = edges;
+            indexSlots();
         };
 
         /**
@@ -107,28 +242,221 @@ class Mesh{
         /**
          * Creat a mesh from an object file
          * @param file A file containing the mesh representation
+         * @param options The options of the load
          * @exception Invalid_Argument if the file is not correct
          * @return A new mesh
         */
-        static Mesh loadOBJ(std::string file);
+        static Mesh loadOBJ(std::string file, const mesh::LoadOptions & options = mesh::LoadOptions());
+
+        /**
+         * Create a mesh from vertices and faces of an obj file, only its connectivity is built (no fitmaps)
+         * @param raw The vertices and faces from the obj file, triangles and quads can be mixed
+         * @exception Invalid_Argument if a face is not a triangle or a quad or if the mesh is not closed
+         * @return A new mesh
+        */
+        static mesh::Mesh objToMesh(const mesh::RawMesh &raw);
 
         /**
          * Create an obj file from a mesh
          * @param file The produced file
+         * @param parallel True to format the file on all the cores
+         * @exception Invalid_Argument if the file is not correct
+        */
+        void toObj(std::string file, bool parallel = true);
+
+        /**
+         * Creat a mesh from a binary little endian ply file
+         * @param file A file containing the mesh representation
+         * @param options The options of the load
+         * @exception Invalid_Argument if the file is not correct
+         * @return A new mesh
+        */
+        static Mesh loadPLY(std::string file, const mesh::LoadOptions & options = mesh::LoadOptions());
+
+        /**
+         * Create a binary little endian ply file from a mesh
+         * @param file The produced file
+         * @param fitmaps True to add the S and M fitmaps as the s_fitmap and m_fitmap vertex properties
+         * @exception Invalid_Argument if the file is not correct
+        */
+        void toPLY(std::string file, bool fitmaps = true);
+
+        /**
+         * Save the whole mesh (connectivity, fitmaps and radii) in a binary snapshot
+         * @param file The produced file
+         * @exception Invalid_Argument if the file is not correct
+        */
+        void saveBinary(std::string file);
+
+        /**
+         * Create a mesh from a binary snapshot made by saveBinary
+         * @param file The snapshot file
+         * @exception Invalid_Argument if the file is not correct
+         * @return A new mesh
+        */
+        static Mesh loadBinary(std::string file);
+
+        /**
+         * Copy the mesh with its own elements, unlike the copy constructor which shares them,
+         * so the copy can be simplified without changing this mesh
+         * The elements keep their ids, slots, attributes and diagonals, the diagonal heap keeps its order
+         * @exception Invalid_Argument if an element is linked to one missing from the lists
+         * @return The new mesh
+        */
+        Mesh clone() const;
+
+        /**
+         * Get the attribute channels of the vertices, indexed by the vertices' slots
+         * They follow the list through the removals, the cleans and the reorders
+         * @return The channels, shared by the copies of the mesh
+        */
+        mesh::AttributeSet & vertexAttributes();
+
+        const mesh::AttributeSet & vertexAttributes() const;
+
+        /**
+         * Get the attribute channels of the faces, indexed by the faces' slots
+         * @return The channels, shared by the copies of the mesh
+        */
+        mesh::AttributeSet & faceAttributes();
+
+        const mesh::AttributeSet & faceAttributes() const;
+
+        /**
+         * Get the attribute channels of the edges, indexed by the edges' slots
+         * @return The channels, shared by the copies of the mesh
+        */
+        mesh::AttributeSet & edgeAttributes();
+
+        const mesh::AttributeSet & edgeAttributes() const;
+
+        /**
+         * Append the mesh as a new level of detail at the end of an archive, with quantized positions
+         * @param file The archive, created if it does not exist
+         * @param bits The number of bits of the quantized coordinates (1 to 24)
          * @exception Invalid_Argument if the file is not correct
         */
-        void toObj(std::string file);
+        void appendToArchive(std::string file, int bits = 16) const;
 
         /**
-         * Check mesh correctness
+         * Get the number of levels of detail in an archive
+         * @param file The archive
+         * @exception Invalid_Argument if the file is not correct
+         * @return The number of levels
+        */
+        static int archiveLevels(std::string file);
+
+        /**
+         * Create a mesh from a level of detail of an archive made by appendToArchive
+         * @param file The archive
+         * @param level The index of the level, in the order they were appended
+         * @param options The options of the load
+         * @exception Invalid_Argument if the file or the level is not correct
+         * @return A new mesh
+        */
+        static Mesh loadArchive(std::string file, int level, const mesh::LoadOptions & options = mesh::LoadOptions());
+
+        /**
+         * Enable or disable the reordering of the mesh's elements at the end of triToQuad,
+         * the loaders set it from their options
+         * @param enabled True to reorder the elements, which moves them all and invalidates the pointers to them
         */
-        void checkCorrectness() const;
+        void setReorder(bool enabled);
 
         /**
-         * Transform a triangular mesh into a quad one
+         * Enable or disable the check of the one-ring touched by each createEdge, removeEdgeV2, diagonalCollapse,
+         * removeDoublet and removeSinglet, which throws at the first operation breaking an invariant
+         * @param enabled True to check the rings, the cost follows the size of the edits and not the mesh's
+        */
+        void setLocalValidation(bool enabled);
+
+        /**
+         * Choose how triToQuad pairs the triangles to merge into quads
+         * @param enabled True to match them in parallel rounds, which leaves no two adjacent triangles unpaired,
+         * false for the sequential greedy pass
+        */
+        void setParallelPairing(bool enabled);
+
+        /**
+         * A broken invariant found by checkCorrectness
+        */
+        struct Violation{
+            /**
+             * The invariants
+            */
+            enum Kind{
+                COUNT,          // a counter differs from the size of its list
+                SLOT,           // the slot of an element is not its index in its list
+                DELETED,        // an element of a list is flagged to delete
+                LINK,           // a link is null or goes to an element flagged or missing from the lists
+                FACE_RING,      // the edges of a face don't close a ring with the face on their right only
+                SINGLET,        // a face has three distinct vertices
+                DOUBLET,        // a face shares two consecutive edges with the same face
+                VERTEX_ANCHOR,  // the edge of a vertex doesn't start or end at it
+                VERTEX_RING,    // the outgoing edges of a vertex don't close a ring
+                REVERSE,        // an edge and its reversed edge don't mirror each other
+                DUPLICATE_EDGE  // two edges have the same origin and destination
+            };
+
+            /**
+             * The kinds of element
+            */
+            enum Element{VERTEX, FACE, EDGE};
+
+            Kind kind;
+            Element element;
+
+            /**
+             * The index of the element in its list, -1 for the counters
+            */
+            int slot;
+
+            /**
+             * Cast a violation into a printable string
+             * @return The violation as a string
+            */
+            std::string toString() const;
+        };
+
+        /**
+         * The broken invariants of a mesh, in the order of the lists
+        */
+        struct CorrectnessReport{
+            std::vector<Violation> violations;
+
+            /**
+             * Check if no invariant is broken
+             * @return True if the mesh is correct
+            */
+            bool isCorrect() const{
+                return violations.empty();
+            }
+
+            /**
+             * Print the violations
+            */
+            void print() const;
+        };
+
+        /**
+         * Check mesh correctness in linear time on all the cores, without stopping at the first broken invariant
+         * The triangles are reported as singlets, so the mesh must be a quad one like after triToQuad
+         * @return The broken invariants
+        */
+        CorrectnessReport checkCorrectness() const;
+
+        /**
+         * Transform a triangular or mixed mesh into a quad one, quad meshes are left untouched
+         * The elements are then reordered if enabled, which invalidates the pointers to them
         */
         void triToQuad();
 
+        /**
+         * Count the number of triangles in the mesh
+         * @return The number of triangles
+        */
+        int howManyTriangles() const;
+
         /**
          * Cast the mesh into a list of printable strings
          * @return The mesh as a string vector
@@ -163,6 +491,27 @@ class Mesh{
         */
         void printStats() const;
 
+        /**
+         * The memory usage of the mesh's storage for each kind of element
+        */
+        struct MemoryStats{
+            mesh::PoolStats vertices;
+            mesh::PoolStats faces;
+            mesh::PoolStats edges;
+            mesh::PoolStats diagonals;
+        };
+
+        /**
+         * Get the memory usage of the mesh's storage
+         * @return The elements alive, the high-water marks and the allocated memory
+        */
+        MemoryStats getMemoryStats() const;
+
+        /**
+         * Print the memory usage of the mesh's storage in the standard output
+        */
+        void printMemoryStats() const;
+
         /**
          * Get the minimum height of one of the object's vertices
          * @return The minimum height as a floating point
@@ -220,12 +569,60 @@ class Mesh{
 
     private:
         /**
-         * Create a mesh from vertices and faces of an obj file
-         * @param vertices The vertices from the obj file
-         * @param faces The faces from the obj file
-         * @return A new mesh
+         * Extract the vertices and faces of the mesh
+         * @return The vertices' coordinates and the faces' vertices indices
+        */
+        mesh::RawMesh toRaw() const;
+
+        /**
+         * Hash the vertices and faces of an obj file and the fitmaps parameters
+         * @param raw The vertices and faces from the obj file
+         * @return The key of the mesh's fitmaps in the cache
+        */
+        static uint64_t fitmapsKey(const mesh::RawMesh &raw);
+
+        /**
+         * Get the radii and the fitmaps from the cache or build them
+         * @param raw The vertices and faces the mesh was built from
+         * @param file The file the mesh was read from
+         * @param options The options of the load
         */
-        static mesh::Mesh objToMesh(std::vector<maths::Vector3*> &vertices, std::vector<std::vector<int>> &faces);
+        void initFitmaps(const mesh::RawMesh &raw, std::string file, const mesh::LoadOptions & options);
+
+        /**
+         * Get the cache file of the fitmaps of an obj file
+         * @param file The obj file
+         * @param key The key of the mesh's fitmaps
+         * @param dir The cache directory, empty for the sidecar file
+         * @return The sidecar file of the obj file or a file named after the key in the cache directory
+        */
+        static std::string fitmapsCacheFile(std::string file, uint64_t key, std::string dir);
+
+        /**
+         * Load the radii and the fitmaps from a cache file
+         * @param file The cache file
+         * @param key The expected key of the mesh's fitmaps
+         * @return False if the file is missing, stale or does not match the mesh
+        */
+        bool loadFitmaps(std::string file, uint64_t key);
+
+        /**
+         * Save the radii and the fitmaps in a cache file
+         * @param file The cache file
+         * @param key The key of the mesh's fitmaps
+         * @return False if the file could not be written
+        */
+        bool saveFitmaps(std::string file, uint64_t key) const;
+
+        /**
+         * Get the key of an edge in the sparse edge table
+         * @param v0 The index of the origin vertex
+         * @param v1 The index of the destination vertex
+         * @return The key packing both indices
+        */
+        static uint64_t edgeKey(int v0, int v1){
+            return (uint64_t(uint32_t(v0)) << 32) | uint64_t(uint32_t(v1));
+        };
 
         /**
          * Extract the vertices from the mesh's faces
@@ -233,11 +630,62 @@ class Mesh{
         */
         std::vector<std::vector<mesh::Vertex*>> verticesOfFaces();
 
+        /**
+         * Format a chunk of the vertices or faces of an obj file
+         * @param chunk The index of the chunk, vertices' chunks come first
+         * @param nbVertexChunks The number of vertices' chunks
+         * @param buffer The buffer receiving the formatted lines (cleared first)
+        */
+        void toObjChunk(int chunk, int nbVertexChunks, std::string & buffer) const;
+
+        /**
+         * Check a vertex, its slot, its edge and its ring
+         * @param i The index of the vertex
+         * @param violations Receives the broken invariants
+        */
+        void checkVertex(int i, std::vector<Violation> & violations) const;
+
+        /**
+         * Check a face, its slot and its ring
+         * @param i The index of the face
+         * @param shapes True to also report the singlets and the doublets
+         * @param violations Receives the broken invariants
+        */
+        void checkFace(int i, bool shapes, std::vector<Violation> & violations) const;
+
+        /**
+         * Check an edge, its slot, its links and its reversed edge
+         * @param i The index of the edge
+         * @param violations Receives the broken invariants
+        */
+        void checkEdge(int i, std::vector<Violation> & violations) const;
+
+        /**
+         * Check the faces touched by an operation, the edges around them and their vertices
+         * @param operation The name of the operation, for the error
+         * @param faces The faces touched by the operation, the ones flagged to delete are skipped
+         * @exception Logic_Error if an invariant is broken
+        */
+        void validateAround(const char* operation, const std::vector<mesh::Face*> & faces) const;
+
+        /**
+         * Check that no two edges have the same origin and destination
+         * @param violations Receives the broken invariants
+        */
+        void checkDuplicateEdges(std::vector<Violation> & violations) const;
+
         /**
          * Mark the edges to remove to transform a triangular mesh into a quad one
         */
         void triToQuadRemovalMarkingPhase();
 
+        /**
+         * Mark the edges to remove with a maximal matching of the triangles, in rounds where every free triangle proposes
+         * its squarest merge and the merges proposed by both their triangles are taken
+         * @param sumDotProds The sum of the cosines of the quad's corners of each edge merging two triangles
+        */
+        void matchTriangles(const mesh::AttributeChannel<float> & sumDotProds);
+
         // /**
         //  * Mark the edges to delete to transform a quad-dominant mesh into a real triangular mesh, 
         //  * using catmull-clark subdivision on the remaining triangles
@@ -262,35 +710,35 @@ class Mesh{
         void removeEdgeV2(mesh::Edge* edge);
 
         /**
-         * Remove a face from the list
+         * Remove a face from the list in constant time, the last face takes its slot
          * @param face The face to remove
         */
         void removeFaceFromList(mesh::Face* face);
 
         /**
-         * Remove flagged faces from the list
+         * Remove flagged faces from the list in one pass, keeping the order of the others
         */
         void removeFacesFromList();
 
         /**
-         * Remove an edge from the list
+         * Remove an edge from the list in constant time, the last edge takes its slot
          * @param edge The edge to remove
         */
         void removeEdgeFromList(mesh::Edge* edge);
 
         /**
-         * Remove flagged edges from the list
+         * Remove flagged edges from the list in one pass, keeping the order of the others
         */
         void removeEdgesFromList();
 
         /**
-         * Remove a vertex from the list
+         * Remove a vertex from the list in constant time, the last vertex takes its slot
          * @param vertex The vertex to remove
         */
         void removeVertexFromList(mesh::Vertex* vertex);
 
         /**
-         * Remove flagged vertices from the list
+         * Remove flagged vertices from the list in one pass, keeping the order of the others
         */
         void removeVerticesFromList();
 
@@ -306,12 +754,6 @@ class Mesh{
         */
         mesh::Face* getTriangle();
 
-        /**
-         * Count the number of triangles in the mesh
-         * @return The number of triangles
-        */
-        int howManyTriangles() const;
-
         /**
          * Transform a quad dominant mesh into a pure quad one
         */
@@ -454,17 +896,113 @@ class Mesh{
         int diagonalCollapse();
 
         /**
-         * Clean the mesh
+         * Clean the mesh, the flagged elements are removed from the lists and destroyed
+         * @return The old to new indices of the elements in the lists, valid until the next clean
+        */
+        const CompactionMap & clean();
+
+        /**
+         * Get the indices remapping of the last clean or reorder
+         * @return The old to new indices of the elements in the lists
         */
-        void clean();
+        const CompactionMap & getLastCompaction() const;
 
         /**
-         * Update the diagonal heap
+         * Sort the vertices and the faces along a Z-order curve over the bounding box and the edges face by face,
+         * then move the elements in new pools in this order so neighbours are close in memory
+         * The elements are new ones, the pointers to the old ones held outside the mesh must not be used anymore,
+         * the old to new indices are given by getLastCompaction
+        */
+        void reorder();
+
+        /**
+         * Update the diagonal heap, the diagonals whose priority changed are pushed again
          * @param faces The faces to update
         */
         void updateDiagonals(std::vector<mesh::Face*> faces);
 
     private:
+        /**
+         * Create a vertex in the mesh's storage
+         * @param x The x coordinate
+         * @param y The y coordinate
+         * @param z The z coordinate
+         * @return The new vertex
+        */
+        mesh::Vertex* newVertex(float x, float y, float z);
+
+        /**
+         * Create a face in the mesh's storage
+         * @return The new face
+        */
+        mesh::Face* newFace();
+
+        /**
+         * Create an edge in the mesh's storage
+         * @return The new edge
+        */
+        mesh::Edge* newEdge();
+
+        /**
+         * Destroy a vertex, its slot is reused by the next vertices
+         * @param vertex The vertex, which must not be linked anymore
+        */
+        void deleteVertex(mesh::Vertex* vertex);
+
+        /**
+         * Destroy a face and its diagonal, its slot is reused by the next faces
+         * @param face The face, which must not be linked anymore
+        */
+        void deleteFace(mesh::Face* face);
+
+        /**
+         * Destroy an edge, its slot is reused by the next edges
+         * @param edge The edge, which must not be linked anymore
+        */
+        void deleteEdge(mesh::Edge* edge);
+
+        /**
+         * Set the slot of every element to its index in the lists and size the attribute channels to the lists
+        */
+        void indexSlots();
+
+        /**
+         * Set the diagonal of a face from its vertices, the diagonal dropped by a face which is not a quad anymore
+         * is kept alive until the next clean removes it from the heap
+         * @param face The face
+         * @param weight The weight of the diagonal's length, the face's S fitmap
+        */
+        void setDiagonal(mesh::Face* face, float weight);
+
+        /**
+         * Push a new entry of a diagonal in the heap with its current weighted length, its older entries become stale
+         * @param diag The diagonal
+        */
+        void pushDiagonal(mesh::Diagonal* diag);
+
+        /**
+         * Copy the mesh with its own elements created in a given order
+         * @param vertexOrder The index of the vertex to copy at each position of the new list
+         * @param faceOrder The index of the face to copy at each position of the new list
+         * @param edgeOrder The index of the edge to copy at each position of the new list
+         * @exception Invalid_Argument if an element is linked to one missing from the lists
+         * @return The new mesh
+        */
+        Mesh copyInOrder(const std::vector<int> & vertexOrder, const std::vector<int> & faceOrder, 
+                const std::vector<int> & edgeOrder) const;
+
+        /**
+         * Sort the vertices and the faces of a mesh read from a file along a Z-order curve over its bounding box
+         * and remap the faces, so the mesh built from it has neighbours close in memory
+         * @param raw The mesh to sort
+        */
+        static void reorderRawMesh(mesh::RawMesh & raw);
+
+        /**
+         * Remove the stale entries from the heap, then destroy the diagonals dropped by their faces
+        */
+        void removeDeletedDiagonals();
+
         /**
          * Remove a doublet
          * @param e1 The first edge of the doublet
@@ -507,27 +1045,27 @@ class Mesh{
         void initRadii();
 
         /**
-         * Init neighbourhoods
-         * @param v The current vertex
-         * @return The neighbourhood as a matrix of vertices
+         * Flatten the vertices' coordinates, neighbours and surrounding faces' normals for the neighbourhood searches
+         * @param faceNormals The normals of the faces
+         * @param graph Receive the flattened vertices
         */
-        std::vector<std::vector<mesh::Vertex*>> initNeighbourhood(mesh::Vertex* v) const;
+        void initNeighbourhoodGraph(const mesh::AttributeChannel<maths::Vector3> & faceNormals, NeighbourhoodGraph & graph) const;
 
         /**
-         * Init neighbourhoods faces
-         * @param bpis All the vertices neighbourhoods
-         * @return The neighbourhood as a matrix of faces
+         * Init neighbourhoods, a breadth first search from v bounded by the largest radius and MAX_NEIGHBOURHOOD
+         * @param v The slot of the current vertex
+         * @param graph The flattened vertices
+         * @param neighbours Receive the neighbourhood as a matrix of vertices' slots, one row per radius
         */
-        std::vector<std::vector<mesh::Face*>> initNeighbourhoodFaces(std::vector<std::vector<mesh::Vertex*>> bpis);
-
+        void initNeighbourhood(int v, const NeighbourhoodGraph & graph, std::vector<std::vector<int>> & neighbours) const;
 
         /**
          * Get the fitting error for a neighbourhood and a given plane
-         * @param bpi The current neighbourhood
+         * @param bpi The coordinates of the current neighbourhood
          * @param plane The interpolated plane
          * @return The fitting error as a floating point        
         */
-        float getFittingError(std::vector<mesh::Vertex*> bpi, maths::Vector3 plane) const;
+        float getFittingError(const std::vector<maths::Vector3> & bpi, const maths::Vector3 & plane) const;
 
 
         /**
@@ -538,12 +1076,14 @@ class Mesh{
         float getQuadraticFittingErrors(std::vector<float> errors) const;
 
         /**
-         * Get the number of faces inconsistently oriented with the given normal of a plane
-         * @param n The normal of the plane
-         * @param bpiFace The neighbourhood considered
-         * @return The number of faces
+         * Check for each neighbourhood if the ratio of its faces inconsistently oriented with the normal of its plane is within THO_FITMAP
+         * @param n The normals of the planes, one per radius
+         * @param bpis All the vertices neighbourhoods
+         * @param graph The flattened vertices
+         * @param consistent Receive true for the consistent neighbourhoods, one per radius
         */
-        int getNbInconsistentlyOriented(maths::Vector3* n, std::vector<mesh::Face*> bpiFace);
+        void getConsistentlyOriented(const std::vector<maths::Vector3> & n, const std::vector<std::vector<int>> & bpis,
+            const NeighbourhoodGraph & graph, std::vector<char> & consistent) const;
 
 
 
@@ -0,0 +1,310 @@
+#include "meshArchive.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace{
+
+void corrupted(){
+    std::fprintf(stderr, "Error, the mesh archive is corrupted!\n");
+    throw std::invalid_argument("Need a correct mesh archive as input!\n");
+}
+
+void writeVarint(std::string & out, int32_t value){
+    // zigzag so small negative deltas take few bytes
+    uint32_t zigzag = (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+    while (zigzag >= 0x80){
+        out += char((zigzag & 0x7f) | 0x80);
+        zigzag >>= 7;
+    }
+    out += char(zigzag);
+}
+
+void writeToken(std::string & out, uint32_t token){
+    while (token >= 0x80){
+        out += char((token & 0x7f) | 0x80);
+        token >>= 7;
+    }
+    out += char(token);
+}
+
+uint32_t readToken(const char* & cur, const char* end){
+    uint32_t token = 0;
+    for (int shift = 0; shift < 35; shift += 7){
+        if (cur == end) corrupted();
+        uint8_t byte = uint8_t(*cur++);
+        token |= uint32_t(byte & 0x7f) << shift;
+        if (byte < 0x80) return token;
+    }
+    corrupted();
+    return 0;
+}
+
+/**
+ * Tokens of the vertices' indices
+*/
+const uint32_t NEW_VERTEX = 0;
+const uint32_t FIRST_SLOT = 1;
+const int HISTORY_SIZE = 8;
+const uint32_t FIRST_DISTANCE = FIRST_SLOT + HISTORY_SIZE;
+
+/**
+ * The vertices of the last faces, most recent first, in a ring so a push only writes the new face
+*/
+class History{
+
+    public:
+        int find(int id) const{
+            for (int i = 0; i < mSize; i++){
+                if (mIds[(mHead + i) & (HISTORY_SIZE - 1)] == id) return i;
+            }
+            return -1;
+        }
+
+        int get(int slot) const{
+            return slot < mSize ? mIds[(mHead + slot) & (HISTORY_SIZE - 1)] : -1;
+        }
+
+        void push(const int* face, int size, const int* newIds){
+            mHead = (mHead - size) & (HISTORY_SIZE - 1);
+            for (int j = 0; j < size; j++) mIds[(mHead + j) & (HISTORY_SIZE - 1)] = newIds ? newIds[face[j]] : face[j];
+            mSize = std::min(mSize + size, HISTORY_SIZE);
+        }
+
+    private:
+        int mIds[HISTORY_SIZE];
+        int mHead = 0;
+        int mSize = 0;
+};
+
+int32_t readVarint(const char* & cur, const char* end){
+    uint32_t zigzag = readToken(cur, end);
+    return int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+}
+
+void storeLE32(char* out, uint32_t value){
+    for (int i = 0; i < 4; i++) out[i] = char(value >> (8*i));
+}
+
+uint32_t loadLE32(const char* cur){
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= uint32_t(uint8_t(cur[i])) << (8*i);
+    return value;
+}
+
+void storeFloatLE32(char* out, float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    storeLE32(out, bits);
+}
+
+float loadFloatLE32(const char* cur){
+    uint32_t bits = loadLE32(cur);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+void mesh::MeshArchive::encode(const mesh::RawMesh & raw, const float min[3], const float max[3], int bits, std::string & out){
+    if (bits < 1 || bits > 24){
+        std::fprintf(stderr, "Error, %d bits per coordinate is not supported!\n", bits);
+        throw std::invalid_argument("Need between 1 and 24 bits per coordinate!\n");
+    }
+    for (int i = 0; i < raw.nbFaces(); i++){
+        int size = raw.faceSize(i);
+        if (size != 3 && size != 4){
+            std::fprintf(stderr, "Error, face %d has %d vertices!\n", i, size);
+            throw std::invalid_argument("Need a mesh of triangles and quads as input!\n");
+        }
+    }
+
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.bits = bits;
+    header.nbVertices = raw.nbVertices();
+    header.nbFaces = raw.nbFaces();
+    header.nbIndices = int32_t(raw.indices.size());
+    std::memcpy(header.min, min, sizeof(header.min));
+    std::memcpy(header.max, max, sizeof(header.max));
+
+    size_t headerPos = out.size();
+    out.append(HEADER_SIZE, '\0');
+    size_t payloadPos = out.size();
+
+    // number the vertices in the order the faces use them, the unused ones at the end
+    std::vector<int> newIds(raw.nbVertices(), -1);
+    std::vector<int> order;
+    order.reserve(raw.nbVertices());
+    for (int idx : raw.indices){
+        if (newIds[idx] < 0){
+            newIds[idx] = int(order.size());
+            order.push_back(idx);
+        }
+    }
+    for (int i = 0; i < raw.nbVertices(); i++){
+        if (newIds[i] < 0){
+            newIds[i] = int(order.size());
+            order.push_back(i);
+        }
+    }
+
+    // quantize the positions in the bounding box and code the difference with the previous vertex
+    const int32_t maxQuantized = (1 << bits) - 1;
+    float scale[3];
+    for (int j = 0; j < 3; j++) scale[j] = max[j] > min[j] ? float(maxQuantized) / (max[j] - min[j]) : 0.0f;
+    int32_t prev[3] = {0, 0, 0};
+    for (int i : order){
+        for (int j = 0; j < 3; j++){
+            float pos = std::round((raw.coords[3*i+j] - min[j]) * scale[j]);
+            int32_t quantized = int32_t(std::fmin(std::fmax(pos, 0.0f), float(maxQuantized)));
+            writeVarint(out, quantized - prev[j]);
+            prev[j] = quantized;
+        }
+    }
+
+    // one bit per face, set for quads
+    std::string quads((raw.nbFaces() + 7) / 8, '\0');
+    for (int i = 0; i < raw.nbFaces(); i++){
+        if (raw.faceSize(i) == 4) quads[i >> 3] |= char(1 << (i & 7));
+    }
+    out += quads;
+
+    // code every index as a new vertex, a vertex of the last faces or a distance to the last new vertex
+    History history;
+    int nbUsed = 0;
+    for (int i = 0; i < raw.nbFaces(); i++){
+        const int* face = &raw.indices[raw.offsets[i]];
+        int size = raw.faceSize(i);
+        for (int j = 0; j < size; j++){
+            int id = newIds[face[j]];
+            int slot = history.find(id);
+            if (id == nbUsed){
+                writeToken(out, NEW_VERTEX);
+                nbUsed++;
+            }
+            else if (slot >= 0){
+                writeToken(out, FIRST_SLOT + slot);
+            }
+            else{
+                writeToken(out, FIRST_DISTANCE + (nbUsed - 1 - id));
+            }
+        }
+        history.push(face, size, newIds.data());
+    }
+
+    header.payloadSize = out.size() - payloadPos;
+    writeHeader(header, &out[headerPos]);
+}
+
+void mesh::MeshArchive::writeHeader(const Header & header, char* out){
+    // every field is stored in little endian, whatever the host
+    storeLE32(out, header.magic);
+    storeLE32(out + 4, header.version);
+    storeLE32(out + 8, uint32_t(header.bits));
+    storeLE32(out + 12, uint32_t(header.nbVertices));
+    storeLE32(out + 16, uint32_t(header.nbFaces));
+    storeLE32(out + 20, uint32_t(header.nbIndices));
+    storeLE32(out + 24, uint32_t(header.payloadSize));
+    storeLE32(out + 28, uint32_t(header.payloadSize >> 32));
+    for (int j = 0; j < 3; j++){
+        storeFloatLE32(out + 32 + 4*j, header.min[j]);
+        storeFloatLE32(out + 44 + 4*j, header.max[j]);
+    }
+}
+
+mesh::MeshArchive::Header mesh::MeshArchive::readHeader(const char* & cur, const char* end){
+    Header header;
+    if (size_t(end - cur) < HEADER_SIZE) corrupted();
+    header.magic = loadLE32(cur);
+    header.version = loadLE32(cur + 4);
+    header.bits = int32_t(loadLE32(cur + 8));
+    header.nbVertices = int32_t(loadLE32(cur + 12));
+    header.nbFaces = int32_t(loadLE32(cur + 16));
+    header.nbIndices = int32_t(loadLE32(cur + 20));
+    header.payloadSize = loadLE32(cur + 24) | uint64_t(loadLE32(cur + 28)) << 32;
+    for (int j = 0; j < 3; j++){
+        header.min[j] = loadFloatLE32(cur + 32 + 4*j);
+        header.max[j] = loadFloatLE32(cur + 44 + 4*j);
+    }
+    cur += HEADER_SIZE;
+
+    if (header.magic != MAGIC || header.version != VERSION){
+        std::fprintf(stderr, "Error, not a mesh archive of version %u!\n", VERSION);
+        throw std::invalid_argument("Need a mesh archive as input!\n");
+    }
+    if (header.bits < 1 || header.bits > 24 || header.nbVertices < 0 || header.nbFaces < 0
+        || header.nbIndices < 3*int64_t(header.nbFaces) || header.nbIndices > 4*int64_t(header.nbFaces)
+        || header.payloadSize > uint64_t(end - cur)
+        // every coordinate and index takes at least one byte
+        || 3*uint64_t(header.nbVertices) + uint64_t(header.nbIndices) > header.payloadSize){
+        corrupted();
+    }
+    return header;
+}
+
+void mesh::MeshArchive::skip(const char* & cur, const char* end){
+    Header header = readHeader(cur, end);
+    cur += header.payloadSize;
+}
+
+void mesh::MeshArchive::decode(const char* & cur, const char* end, mesh::RawMesh & raw){
+    Header header = readHeader(cur, end);
+    const char* payloadEnd = cur + header.payloadSize;
+
+    // the vertices
+    int firstVertex = raw.nbVertices();
+    float step[3];
+    for (int j = 0; j < 3; j++){
+        step[j] = (header.max[j] - header.min[j]) / float((1 << header.bits) - 1);
+    }
+    size_t coordsPos = raw.coords.size();
+    raw.coords.resize(coordsPos + 3*size_t(header.nbVertices));
+    float* coords = raw.coords.data() + coordsPos;
+    int64_t prev[3] = {0, 0, 0};
+    for (int i = 0; i < header.nbVertices; i++){
+        for (int j = 0; j < 3; j++){
+            prev[j] += readVarint(cur, payloadEnd);
+            coords[3*i+j] = header.min[j] + float(prev[j]) * step[j];
+        }
+    }
+
+    // the faces
+    size_t quadsSize = (size_t(header.nbFaces) + 7) / 8;
+    if (size_t(payloadEnd - cur) < quadsSize) corrupted();
+    const char* quads = cur;
+    cur += quadsSize;
+
+    size_t indicesPos = raw.indices.size();
+    raw.indices.resize(indicesPos + size_t(header.nbIndices));
+    raw.offsets.reserve(raw.offsets.size() + header.nbFaces);
+    int* indices = raw.indices.data() + indicesPos;
+    int nbIndices = 0;
+    int nbUsed = 0;
+    History history;
+    for (int i = 0; i < header.nbFaces; i++){
+        int size = (quads[i >> 3] >> (i & 7)) & 1 ? 4 : 3;
+        if (nbIndices + size > header.nbIndices) corrupted();
+        int* face = indices + nbIndices;
+        for (int j = 0; j < size; j++){
+            uint32_t token = readToken(cur, payloadEnd);
+            int64_t id;
+            if (token == NEW_VERTEX) id = nbUsed++;
+            else if (token < FIRST_DISTANCE) id = history.get(int(token - FIRST_SLOT));
+            else id = int64_t(nbUsed) - 1 - int64_t(token - FIRST_DISTANCE);
+            if (id < 0 || id >= header.nbVertices) corrupted();
+            face[j] = int(id);
+        }
+        history.push(face, size, nullptr);
+        for (int j = 0; j < size; j++) face[j] += firstVertex;
+        nbIndices += size;
+        raw.offsets.push_back(int(indicesPos) + nbIndices);
+    }
+    if (nbIndices != header.nbIndices || cur != payloadEnd) corrupted();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "rawMesh.hpp"
+
+namespace mesh{
+
+/**
+ * A compact format for the levels of detail of a mesh
+ * Every level is a header followed by the vertices' positions quantized in the bounding box
+ * and delta coded, one bit per face telling if it is a quad and the vertices' indices,
+ * so the levels can be appended to an archive and decoded one after the other
+ * The vertices are numbered in the order the faces use them, so an index is mostly a new vertex
+ * or a vertex of the last faces and takes a single byte
+ * The format is meant for size: decoding a level is bound by a branch per index and is only
+ * 2 to 4 times faster than parsing the same mesh from an obj file
+ * Every field is stored in little endian, so archives move between hosts
+*/
+class MeshArchive{
+
+    public:
+        /**
+         * Encode a level
+         * @param raw The vertices and faces of the level, made of triangles and quads
+         * @param min The minimum of the bounding box
+         * @param max The maximum of the bounding box
+         * @param bits The number of bits of the quantized coordinates (1 to 24)
+         * @param out The buffer in which the level is appended
+         * @exception Invalid_Argument if a face is not a triangle or a quad or the number of bits is not correct
+        */
+        static void encode(const mesh::RawMesh & raw, const float min[3], const float max[3], int bits, std::string & out);
+
+        /**
+         * Decode a level and move after it
+         * @param cur The first byte of the level
+         * @param end The byte past the end of the archive
+         * @param raw The mesh in which the vertices and faces are appended, in the order of the faces
+         * @exception Invalid_Argument if the level is not correct
+        */
+        static void decode(const char* & cur, const char* end, mesh::RawMesh & raw);
+
+        /**
+         * Move after a level without decoding it
+         * @param cur The first byte of the level
+         * @param end The byte past the end of the archive
+         * @exception Invalid_Argument if the level is not correct
+        */
+        static void skip(const char* & cur, const char* end);
+
+    private:
+        /**
+         * Magic number of the levels
+        */
+        static constexpr uint32_t MAGIC = 0x414d5141; // "AQMA"
+
+        /**
+         * Version of the levels
+        */
+        static constexpr uint32_t VERSION = 1;
+
+        /**
+         * The size of a header in the archive, its fields are stored in little endian in the order of Header
+        */
+        static constexpr size_t HEADER_SIZE = 56;
+
+        /**
+         * The header of a level
+        */
+        struct Header{
+            uint32_t magic;
+            uint32_t version;
+            int32_t bits;
+            int32_t nbVertices;
+            int32_t nbFaces;
+            int32_t nbIndices;
+            uint64_t payloadSize;
+            float min[3];
+            float max[3];
+        };
+
+        /**
+         * Write the header of a level
+         * @param header The header
+         * @param out The HEADER_SIZE bytes in which the header is written
+        */
+        static void writeHeader(const Header & header, char* out);
+
+        /**
+         * Read and check the header of a level
+         * @param cur The first byte of the level, moved after the header
+         * @param end The byte past the end of the archive
+         * @return The header
+         * @exception Invalid_Argument if the header is not correct
+        */
+        static Header readHeader(const char* & cur, const char* end);
+};
+
+}
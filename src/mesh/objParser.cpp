@@ -0,0 +1,123 @@
+#include "objParser.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "utils.hpp"
+
+namespace{
+
+bool isBlank(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipBlanks(const char* cur, const char* eol){
+    while (cur < eol && isBlank(*cur)) cur++;
+    return cur;
+}
+
+// from_chars rejects the '+' sign that scanf accepted
+const char* skipPlus(const char* cur, const char* eol){
+    if (cur < eol && *cur == '+') cur++;
+    return cur;
+}
+
+}
+
+void mesh::ObjParser::parseVertex(const char* cur, const char* eol, mesh::RawMesh & raw){
+    for (int i = 0; i < 3; i++){
+        float value;
+        cur = skipPlus(skipBlanks(cur, eol), eol);
+        std::from_chars_result res = std::from_chars(cur, eol, value);
+        if (res.ec != std::errc()){
+            std::fprintf(stderr, "Error, failed to parse a vertex!\n");
+            throw std::invalid_argument("Need a correct obj file as input!\n");
+        }
+        raw.coords.push_back(value);
+        cur = res.ptr;
+    }
+}
+
+void mesh::ObjParser::parseFace(const char* cur, const char* eol, mesh::RawMesh & raw){
+    while (true){
+        int idx;
+        cur = skipPlus(skipBlanks(cur, eol), eol);
+        std::from_chars_result res = std::from_chars(cur, eol, idx);
+        if (res.ec != std::errc()) break;
+        raw.indices.push_back(idx - 1);
+        // skip the texture and normal indices
+        cur = res.ptr;
+        while (cur < eol && !isBlank(*cur)) cur++;
+    }
+    raw.offsets.push_back(int(raw.indices.size()));
+}
+
+void mesh::ObjParser::parse(const char* begin, const char* end, mesh::RawMesh & raw){
+    const char* cur = begin;
+    while (cur < end){
+        const char* eol = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        if (eol == nullptr) eol = end;
+
+        if (eol - cur >= 2 && isBlank(cur[1])){
+            if (cur[0] == 'v') parseVertex(cur + 1, eol, raw);
+            else if (cur[0] == 'f') parseFace(cur + 1, eol, raw);
+        }
+
+        cur = eol + 1;
+    }
+}
+
+void mesh::ObjParser::merge(const std::vector<mesh::RawMesh> & chunks, mesh::RawMesh & raw){
+    int nbChunks = int(chunks.size());
+
+    // get where each chunk starts in the merged arrays
+    std::vector<size_t> coordsStart(nbChunks + 1, raw.coords.size());
+    std::vector<size_t> indicesStart(nbChunks + 1, raw.indices.size());
+    std::vector<size_t> offsetsStart(nbChunks + 1, raw.offsets.size());
+    for (int i = 0; i < nbChunks; i++){
+        coordsStart[i+1] = coordsStart[i] + chunks[i].coords.size();
+        indicesStart[i+1] = indicesStart[i] + chunks[i].indices.size();
+        offsetsStart[i+1] = offsetsStart[i] + chunks[i].offsets.size() - 1;
+    }
+    raw.coords.resize(coordsStart[nbChunks]);
+    raw.indices.resize(indicesStart[nbChunks]);
+    raw.offsets.resize(offsetsStart[nbChunks]);
+
+    // copy every chunk at its place, shifting the face offsets
+    utils::parallelFor(nbChunks, [&](int i){
+        const mesh::RawMesh & chunk = chunks[i];
+        std::copy(chunk.coords.begin(), chunk.coords.end(), raw.coords.begin() + coordsStart[i]);
+        std::copy(chunk.indices.begin(), chunk.indices.end(), raw.indices.begin() + indicesStart[i]);
+        int shift = int(indicesStart[i]);
+        for (int j = 1; j < int(chunk.offsets.size()); j++)
+            raw.offsets[offsetsStart[i] + j - 1] = chunk.offsets[j] + shift;
+    });
+}
+
+void mesh::ObjParser::parseParallel(const char* begin, const char* end, mesh::RawMesh & raw){
+    long size = end - begin;
+    int nbChunks = int(std::min(long(utils::nbThreads()), size / MIN_CHUNK_SIZE + 1));
+    if (nbChunks <= 1){
+        parse(begin, end, raw);
+        return;
+    }
+
+    // split the file into chunks of whole lines
+    std::vector<const char*> bounds(nbChunks + 1, end);
+    bounds[0] = begin;
+    for (int i = 1; i < nbChunks; i++){
+        const char* cur = std::max(begin + size * i / nbChunks, bounds[i-1]);
+        const char* eol = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        bounds[i] = eol ? eol + 1 : end;
+    }
+
+    std::vector<mesh::RawMesh> chunks(nbChunks);
+    utils::parallelFor(nbChunks, [&](int i){
+        parse(bounds[i], bounds[i+1], chunks[i]);
+    });
+
+    merge(chunks, raw);
+}
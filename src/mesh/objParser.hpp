@@ -0,0 +1,63 @@
+#pragma once
+
+#include "rawMesh.hpp"
+
+namespace mesh{
+
+/**
+ * A parser reading the vertices and the faces of an obj file in place
+*/
+class ObjParser{
+
+    public:
+        /**
+         * Parse the content of an obj file
+         * @param begin The first character of the file
+         * @param end The character past the end of the file
+         * @param raw The mesh in which the vertices and faces are appended
+         * @exception Invalid_Argument if a vertex is not correct
+        */
+        static void parse(const char* begin, const char* end, mesh::RawMesh & raw);
+
+        /**
+         * Parse the content of an obj file on all the cores
+         * The file is split into chunks of whole lines parsed separately and merged in order,
+         * so the result is identical to the one of a sequential parse
+         * @param begin The first character of the file
+         * @param end The character past the end of the file
+         * @param raw The mesh in which the vertices and faces are appended
+         * @exception Invalid_Argument if a vertex is not correct
+        */
+        static void parseParallel(const char* begin, const char* end, mesh::RawMesh & raw);
+
+    private:
+        /**
+         * The minimum size of a chunk parsed by one thread
+        */
+        static const long MIN_CHUNK_SIZE = 1 << 20;
+
+        /**
+         * Append the content of parsed chunks to a mesh
+         * @param chunks The chunks in the order of the file
+         * @param raw The mesh in which the vertices and faces are appended
+        */
+        static void merge(const std::vector<mesh::RawMesh> & chunks, mesh::RawMesh & raw);
+
+        /**
+         * Parse a vertex line
+         * @param cur The first character after the 'v'
+         * @param eol The end of the line
+         * @param raw The mesh in which the vertex is appended
+        */
+        static void parseVertex(const char* cur, const char* eol, mesh::RawMesh & raw);
+
+        /**
+         * Parse a face line (f v1 v2 v3 or f v1/./. v2/./. v3/./.)
+         * @param cur The first character after the 'f'
+         * @param eol The end of the line
+         * @param raw The mesh in which the face is appended
+        */
+        static void parseFace(const char* cur, const char* eol, mesh::RawMesh & raw);
+};
+
+}
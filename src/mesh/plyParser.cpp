@@ -0,0 +1,214 @@
+#include "plyParser.hpp"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace{
+
+void truncated(){
+    std::fprintf(stderr, "Error, the ply file is truncated!\n");
+    throw std::invalid_argument("Need a correct ply file as input!\n");
+}
+
+bool isLittleEndian(){
+    const uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+template<typename T>
+T load(const char* cur){
+    T value;
+    std::memcpy(&value, cur, sizeof(T));
+    return value;
+}
+
+}
+
+mesh::PlyParser::Type mesh::PlyParser::typeOf(const std::string & name){
+    if (name == "char" || name == "int8") return INT8;
+    if (name == "uchar" || name == "uint8") return UINT8;
+    if (name == "short" || name == "int16") return INT16;
+    if (name == "ushort" || name == "uint16") return UINT16;
+    if (name == "int" || name == "int32") return INT32;
+    if (name == "uint" || name == "uint32") return UINT32;
+    if (name == "float" || name == "float32") return FLOAT32;
+    if (name == "double" || name == "float64") return FLOAT64;
+    std::fprintf(stderr, "Error, unknown ply type %s!\n", name.c_str());
+    throw std::invalid_argument("Need a correct ply file as input!\n");
+}
+
+int mesh::PlyParser::sizeOf(Type type){
+    switch (type){
+        case INT8: case UINT8: return 1;
+        case INT16: case UINT16: return 2;
+        case INT32: case UINT32: case FLOAT32: return 4;
+        case FLOAT64: return 8;
+    }
+    return 0;
+}
+
+double mesh::PlyParser::read(const char* & cur, const char* end, Type type){
+    int size = sizeOf(type);
+    if (end - cur < size) truncated();
+
+    double value = 0.0;
+    switch (type){
+        case INT8: value = load<int8_t>(cur); break;
+        case UINT8: value = load<uint8_t>(cur); break;
+        case INT16: value = load<int16_t>(cur); break;
+        case UINT16: value = load<uint16_t>(cur); break;
+        case INT32: value = load<int32_t>(cur); break;
+        case UINT32: value = load<uint32_t>(cur); break;
+        case FLOAT32: value = load<float>(cur); break;
+        case FLOAT64: value = load<double>(cur); break;
+    }
+    cur += size;
+    return value;
+}
+
+const char* mesh::PlyParser::parseHeader(const char* begin, const char* end, std::vector<Element> & elements){
+    const char* cur = begin;
+    bool isBinaryLE = false;
+    int nbLines = 0;
+
+    while (cur < end){
+        const char* eol = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        if (eol == nullptr) break;
+        std::istringstream line(std::string(cur, eol));
+        cur = eol + 1;
+
+        std::string keyword;
+        line >> keyword;
+        if (nbLines++ == 0){
+            if (keyword != "ply") break;
+            continue;
+        }
+
+        if (keyword == "format"){
+            std::string format;
+            line >> format;
+            isBinaryLE = format == "binary_little_endian";
+        }
+        else if (keyword == "element"){
+            Element element;
+            line >> element.name >> element.count;
+            if (!line || element.count < 0) break;
+            elements.push_back(element);
+        }
+        else if (keyword == "property"){
+            if (elements.empty()) break;
+            Property property;
+            std::string type;
+            line >> type;
+            if (type == "list"){
+                std::string countType, valueType;
+                line >> countType >> valueType;
+                property.isList = true;
+                property.countType = typeOf(countType);
+                type = valueType;
+            }
+            property.type = typeOf(type);
+            line >> property.name;
+            if (!line) break;
+            elements.back().properties.push_back(property);
+        }
+        else if (keyword == "end_header"){
+            if (!isBinaryLE){
+                std::fprintf(stderr, "Error, only binary little endian ply files are supported!\n");
+                throw std::invalid_argument("Need a binary ply file as input!\n");
+            }
+            return cur;
+        }
+        // comments and obj_info are ignored
+    }
+
+    std::fprintf(stderr, "Error, failed to parse the ply header!\n");
+    throw std::invalid_argument("Need a correct ply file as input!\n");
+}
+
+void mesh::PlyParser::parse(const char* begin, const char* end, mesh::RawMesh & raw){
+    if (!isLittleEndian()){
+        std::fprintf(stderr, "Error, ply files can only be read on little endian hosts!\n");
+        throw std::invalid_argument("Need a little endian host!\n");
+    }
+
+    std::vector<Element> elements;
+    const char* cur = parseHeader(begin, end, elements);
+
+    for (const Element & element : elements){
+        if (element.name == "vertex"){
+            // the position of the coordinates in a vertex, every vertex property is a scalar
+            int stride = 0;
+            int offsets[3] = {-1, -1, -1};
+            Type types[3] = {FLOAT32, FLOAT32, FLOAT32};
+            for (const Property & property : element.properties){
+                if (property.isList){
+                    std::fprintf(stderr, "Error, list properties of vertices are not supported!\n");
+                    throw std::invalid_argument("Need a correct ply file as input!\n");
+                }
+                int axis = property.name == "x" ? 0 : property.name == "y" ? 1 : property.name == "z" ? 2 : -1;
+                if (axis >= 0){
+                    offsets[axis] = stride;
+                    types[axis] = property.type;
+                }
+                stride += sizeOf(property.type);
+            }
+            if (offsets[0] < 0 || offsets[1] < 0 || offsets[2] < 0){
+                std::fprintf(stderr, "Error, the ply vertices have no x, y and z properties!\n");
+                throw std::invalid_argument("Need a correct ply file as input!\n");
+            }
+            if ((end - cur) / stride < element.count) truncated();
+
+            size_t first = raw.coords.size();
+            raw.coords.resize(first + 3*element.count);
+            float* coords = raw.coords.data() + first;
+            for (long i = 0; i < element.count; i++){
+                for (int j = 0; j < 3; j++){
+                    const char* value = cur + offsets[j];
+                    coords[3*i+j] = types[j] == FLOAT32 ? load<float>(value) : float(read(value, end, types[j]));
+                }
+                cur += stride;
+            }
+        }
+        else if (element.name == "face"){
+            // the vertices' indices are in the vertex_indices (or vertex_index) list
+            int indicesProperty = -1;
+            for (int j = 0; j < int(element.properties.size()) && indicesProperty < 0; j++){
+                const Property & property = element.properties[j];
+                if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) indicesProperty = j;
+            }
+            if (indicesProperty < 0){
+                std::fprintf(stderr, "Error, the ply faces have no vertex_indices property!\n");
+                throw std::invalid_argument("Need a correct ply file as input!\n");
+            }
+
+            for (long i = 0; i < element.count; i++){
+                for (int j = 0; j < int(element.properties.size()); j++){
+                    const Property & property = element.properties[j];
+                    int nb = property.isList ? int(read(cur, end, property.countType)) : 1;
+                    if (j != indicesProperty){
+                        for (int k = 0; k < nb; k++) read(cur, end, property.type);
+                        continue;
+                    }
+                    if (end - cur < long(nb) * sizeOf(property.type)) truncated();
+                    for (int k = 0; k < nb; k++) raw.indices.push_back(int(read(cur, end, property.type)));
+                    raw.offsets.push_back(int(raw.indices.size()));
+                }
+            }
+        }
+        else{
+            // skip the other elements
+            for (long i = 0; i < element.count; i++){
+                for (const Property & property : element.properties){
+                    int nb = property.isList ? int(read(cur, end, property.countType)) : 1;
+                    for (int j = 0; j < nb; j++) read(cur, end, property.type);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "rawMesh.hpp"
+
+namespace mesh{
+
+/**
+ * A parser reading the vertices and the faces of a binary little endian ply file in place
+*/
+class PlyParser{
+
+    public:
+        /**
+         * Parse the content of a ply file
+         * Only the x, y and z properties of the vertices and the first list of the faces are kept,
+         * the other properties and elements are skipped
+         * @param begin The first character of the file
+         * @param end The character past the end of the file
+         * @param raw The mesh in which the vertices and faces are appended
+         * @exception Invalid_Argument if the file is not a binary little endian ply file
+        */
+        static void parse(const char* begin, const char* end, mesh::RawMesh & raw);
+
+    private:
+        /**
+         * The scalar types of the ply properties
+        */
+        enum Type {INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64};
+
+        /**
+         * A property of an element as declared in the header
+        */
+        struct Property{
+            std::string name;
+            Type type;
+            bool isList = false;
+            Type countType = UINT8;
+        };
+
+        /**
+         * An element as declared in the header
+        */
+        struct Element{
+            std::string name;
+            long count = 0;
+            std::vector<Property> properties;
+        };
+
+        /**
+         * Parse the header of a ply file
+         * @param begin The first character of the file
+         * @param end The character past the end of the file
+         * @param elements The declared elements, in the order of the file
+         * @return The first character after the header
+         * @exception Invalid_Argument if the header is not correct
+        */
+        static const char* parseHeader(const char* begin, const char* end, std::vector<Element> & elements);
+
+        /**
+         * Get a scalar type from its name
+         * @param name The name of the type (char, uchar, ..., int8, uint8, ...)
+         * @return The type
+         * @exception Invalid_Argument if the type is unknown
+        */
+        static Type typeOf(const std::string & name);
+
+        /**
+         * Get the size of a scalar type
+         * @param type The type
+         * @return The number of bytes of the type
+        */
+        static int sizeOf(Type type);
+
+        /**
+         * Read a scalar and move after it
+         * @param cur The first byte of the scalar
+         * @param end The byte past the end of the file
+         * @param type The type of the scalar
+         * @return The scalar's value
+         * @exception Invalid_Argument if the file is truncated
+        */
+        static double read(const char* & cur, const char* end, Type type);
+};
+
+}
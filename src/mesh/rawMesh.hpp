@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+namespace mesh{
+
+/**
+ * A structure to represent a mesh as read from a file, before building its connectivity
+*/
+struct RawMesh{
+    /**
+     * The vertices' coordinates (x, y and z for each vertex)
+    */
+    std::vector<float> coords;
+
+    /**
+     * The vertices' indices of every faces, one face after the other
+    */
+    std::vector<int> indices;
+
+    /**
+     * The position of each face in the indices (nbFaces + 1 values)
+    */
+    std::vector<int> offsets = {0};
+
+    /**
+     * Get the number of vertices
+     * @return The number of vertices
+    */
+    int nbVertices() const {return int(coords.size() / 3);};
+
+    /**
+     * Get the number of faces
+     * @return The number of faces
+    */
+    int nbFaces() const {return int(offsets.size()) - 1;};
+
+    /**
+     * Get the number of vertices of a face
+     * @param face The index of the face
+     * @return The number of vertices around the face
+    */
+    int faceSize(int face) const {return offsets[face+1] - offsets[face];};
+};
+
+}
@@ -1,11 +1,13 @@
 #include "vertex.hpp"
 #include "maths.hpp"
+#include "vector3Batch.hpp"
 
 #include <sstream>
 #include <iterator>
 #include <set>
+#include <unordered_set>
+#include <cstdint>
 
-int mesh::Vertex::ID_CPT = 0;
 
 std::string mesh::Vertex::toString() const {
     char buffer[50];
@@ -111,25 +113,20 @@ std::string mesh::Vertex::listToString(std::vector<mesh::Vertex*> list){
     return imploded.str();
 }
 
-bool mesh::Vertex::twoSameEdges(std::vector<mesh::Edge*> edges, int nbVertices){
-	std::vector<std::vector<mesh::Edge*>> table(nbVertices, std::vector<mesh::Edge*>(nbVertices, nullptr));
-    // printf("\nBefore nbVertices: %d\n", nbVertices);
+bool mesh::Vertex::twoSameEdges(const std::vector<mesh::Edge*> & edges){
+    // a set of (origin, destination) pairs, growing with the number of edges instead of the square of the ids
+    std::unordered_set<uint64_t> pairs;
+    pairs.reserve(edges.size());
     for(int i=0; i<int(edges.size()); i++){
-        int v0 = edges[i]->mVertexOrigin->mId;
-        int v1 = edges[i]->mVertexDestination->mId;
-        // edges[i]->print();
-        // printf("nbVertices: %d\n", nbVertices);
-        if(table[v0][v1] != nullptr) {
-            // table[v0][v1]->print();
-            return true;
-        }
-        table[v0][v1] = edges[i];
+        uint32_t v0 = uint32_t(edges[i]->mVertexOrigin->mId);
+        uint32_t v1 = uint32_t(edges[i]->mVertexDestination->mId);
+        if(!pairs.insert((uint64_t(v0) << 32) | v1).second) return true;
     }
     return false;
 }
 
 glm::vec3 mesh::Vertex::toGlm() const{
-    return mCoords->toGlm();
+    return mCoords.toGlm();
 }
 
 std::vector<mesh::Face*> mesh::Vertex::getSurroundingFaces() const{
@@ -257,37 +254,19 @@ float mesh::Vertex::getAverageEdgeLength(std::vector<mesh::Vertex*> vertices){
     return sum / float(surEdges.size());
 }
 
-maths::Vector3* mesh::Vertex::getInterpolatedPlane(std::vector<mesh::Vertex*> vertices){
+maths::Vector3 mesh::Vertex::getInterpolatedPlane(const std::vector<mesh::Vertex*> & vertices){
     // create the plane (Ordinary Least Squares)
-    float sumX = 0.0f; float sumY = 0.0f; float sumZ = 0.0f;
-    float sumXY = 0.0f; float sumXZ = 0.0f; float sumYZ = 0.0f;
-    float sumXX = 0.0f; float sumYY = 0.0f;
-
-    for(int i=0; i<int(vertices.size()); i++){
-        maths::Vector3* curPoint = vertices[i]->mCoords;
-        float x = curPoint->x(); float y = curPoint->y(); float z = curPoint->z();
-        sumX += x; sumY += y; sumZ += z;
-        sumXX += x*x; sumYY += y*y;
-        sumXY += x*z; sumYZ += y*z;
-    }
-    glm::mat3 matA = {
-        sumXX, sumXY, sumX,
-        sumXY, sumYY, sumY,
-        sumX, sumY, vertices.size()
-    };
-    glm::vec3 vecB = {sumXZ, sumYZ, sumZ};
-
-    glm::vec3 planeCoeffs = glm::inverse(matA)*vecB;
-
-    // convert to vector3
-    return new maths::Vector3(planeCoeffs.x, planeCoeffs.y, planeCoeffs.z);
+    std::vector<maths::Vector3> points;
+    points.reserve(vertices.size());
+    for(int i=0; i<int(vertices.size()); i++) points.push_back(vertices[i]->mCoords);
+    return maths::Vector3Batch::fitPlane(points.data(), int(points.size()));
 }
 
 std::vector<float> mesh::Vertex::getSquaredDotProducts(maths::Vector3 normal, std::vector<mesh::Vertex*> vertices){
     std::vector<float> dotProds;
 
     for(int i=0; i<int(vertices.size()); i++){
-        float curDot = maths::Vector3::dot(normal.normalize(), vertices[i]->mCoords->normalize());
+        float curDot = maths::Vector3::dot(normal.normalize(), vertices[i]->mCoords.normalize());
         dotProds.push_back(curDot*curDot);
     }
 
@@ -16,20 +16,19 @@ class Vertex{
 
     public:
         /**
-         * The id counter
+         * The vertex's id, unique in its mesh, -1 until the mesh creates it
         */
-        static int ID_CPT;
+        int mId = -1;
 
-    public:
         /**
-         * The vertex's id
+         * The vertex's index in its mesh's list, -1 when it is in none
         */
-        int mId = (mesh::Vertex::ID_CPT++);
+        int mSlot = -1;
 
         /**
          * The vertex coordinates
         */
-        maths::Vector3* mCoords;
+        maths::Vector3 mCoords;
 
         /**
          *  One of the surronding edge
@@ -41,16 +40,6 @@ class Vertex{
         */
         bool mToDelete = false;
 
-        /**
-         * The S Fitmap
-        */
-        float mSFitmap = 0.0f;
-        
-        /**
-         * The M fitmap
-        */
-        float mMFitmap = 0.0f;
-
         /**
          * The list of neighbour vertices (at initialization)
         */
@@ -67,7 +56,7 @@ class Vertex{
          * @param coords The vertex's coordinates
          * @param edge The edge we'll store
         */
-        Vertex(maths::Vector3* coords = nullptr, mesh::Edge* edge = nullptr){
+        Vertex(const maths::Vector3 & coords = maths::Vector3(), mesh::Edge* edge = nullptr){
             mCoords = coords;
             mEdge = edge;
         };
@@ -136,10 +125,9 @@ class Vertex{
         /**
          * Check if there exists two edges with the same origin and destination
          * @param edges The list to check
-         * @param nbVertices The total number of possible vertices
          * @return True if there exists such edges
         */
-        static bool twoSameEdges(std::vector<mesh::Edge*> edges, int nbVertices);
+        static bool twoSameEdges(const std::vector<mesh::Edge*> & edges);
 
         /**
          * Cast a vertex into a glm vector
@@ -200,7 +188,7 @@ class Vertex{
          * @param vertices The vertices to interpolate as a plane
          * @return The plane a, b, and c values in a vector3
         */
-		static maths::Vector3* getInterpolatedPlane(std::vector<mesh::Vertex*> vertices);
+		static maths::Vector3 getInterpolatedPlane(const std::vector<mesh::Vertex*> & vertices);
 
         /**
          * Get the dot products between a given normal and a list of vertices
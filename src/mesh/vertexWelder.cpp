@@ -0,0 +1,220 @@
+#include "vertexWelder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace{
+
+uint64_t cellKey(int64_t x, int64_t y, int64_t z){
+    // 21 bits per axis, distant cells sharing a key only cost extra distance tests
+    const uint64_t mask = (1 << 21) - 1;
+    return (uint64_t(x) & mask) | ((uint64_t(y) & mask) << 21) | ((uint64_t(z) & mask) << 42);
+}
+
+/**
+ * A flat hash table with linear probing from keys to the head of a chained list of indices
+*/
+class HeadTable{
+
+    public:
+        HeadTable(){
+            mMask = 1023;
+            mKeys.resize(mMask + 1);
+            mHeads.assign(mMask + 1, -1);
+        }
+
+        /**
+         * Get the head of a key's list, the key is added if new and its head must then be set
+         * @return A reference to the head (-1 for a new key), valid until the next call
+        */
+        int & head(uint64_t key){
+            // keep the load under one half
+            if (2*(mSize + 1) > mMask + 1) grow();
+            size_t slot = mix(key) & mMask;
+            while (mHeads[slot] >= 0 && mKeys[slot] != key) slot = (slot + 1) & mMask;
+            if (mHeads[slot] < 0){
+                mKeys[slot] = key;
+                mSize++;
+            }
+            return mHeads[slot];
+        }
+
+        /**
+         * Get the head of a key's list without adding the key
+         * @return The head, -1 if the key is unknown
+        */
+        int find(uint64_t key) const{
+            size_t slot = mix(key) & mMask;
+            while (mHeads[slot] >= 0){
+                if (mKeys[slot] == key) return mHeads[slot];
+                slot = (slot + 1) & mMask;
+            }
+            return -1;
+        }
+
+    private:
+        static uint64_t mix(uint64_t key){
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            return key;
+        }
+
+        void grow(){
+            std::vector<uint64_t> keys;
+            std::vector<int> heads;
+            keys.swap(mKeys);
+            heads.swap(mHeads);
+            mMask = 2*(mMask + 1) - 1;
+            mKeys.resize(mMask + 1);
+            mHeads.assign(mMask + 1, -1);
+            for (size_t i = 0; i < keys.size(); i++){
+                if (heads[i] < 0) continue;
+                size_t slot = mix(keys[i]) & mMask;
+                while (mHeads[slot] >= 0) slot = (slot + 1) & mMask;
+                mKeys[slot] = keys[i];
+                mHeads[slot] = heads[i];
+            }
+        }
+
+        size_t mMask;
+        size_t mSize = 0;
+        std::vector<uint64_t> mKeys;
+        std::vector<int> mHeads;
+};
+
+}
+
+int mesh::VertexWelder::weld(mesh::RawMesh & raw, float tolerance){
+    int nbVertices = raw.nbVertices();
+    if (nbVertices == 0 || tolerance <= 0.0f) return 0;
+
+    for (int i = 0; i < int(raw.indices.size()); i++){
+        if (raw.indices[i] < 0 || raw.indices[i] >= nbVertices){
+            std::fprintf(stderr, "Error, a face uses the vertex %d which does not exist!\n", raw.indices[i] + 1);
+            throw std::invalid_argument("Need a correct mesh as input!\n");
+        }
+    }
+
+    // get the bounding box
+    float min[3] = {raw.coords[0], raw.coords[1], raw.coords[2]};
+    float max[3] = {raw.coords[0], raw.coords[1], raw.coords[2]};
+    for (int i = 0; i < nbVertices; i++){
+        for (int j = 0; j < 3; j++){
+            min[j] = std::min(min[j], raw.coords[3*i+j]);
+            max[j] = std::max(max[j], raw.coords[3*i+j]);
+        }
+    }
+    float diag = std::sqrt((max[0]-min[0])*(max[0]-min[0]) + (max[1]-min[1])*(max[1]-min[1]) + (max[2]-min[2])*(max[2]-min[2]));
+    float eps = tolerance * diag;
+    if (eps <= 0.0f) return 0;
+    float eps2 = eps * eps;
+    float cellSize = 2.0f * eps;
+
+    // the cells are twice as large as the tolerance, so the close vertices are in the cell
+    // or in the neighbouring cells on the side of the nearest borders (8 cells instead of 27)
+    // every cell holds a list of kept vertices chained through next
+    HeadTable cells;
+    std::vector<int> next(nbVertices, -1);
+    std::vector<int> remap(nbVertices);
+    std::vector<int> kept;
+    kept.reserve(nbVertices);
+
+    for (int i = 0; i < nbVertices; i++){
+        const float* p = &raw.coords[3*i];
+        int64_t cell[3];
+        int side[3];
+        for (int j = 0; j < 3; j++){
+            float pos = (p[j] - min[j]) / cellSize;
+            cell[j] = int64_t(std::floor(pos));
+            side[j] = pos - float(cell[j]) < 0.5f ? -1 : 1;
+        }
+
+        // the vertex's own cell comes first and the search stops at the first match,
+        // the scan order only depends on the file so the result does not depend on the hash
+        int match = -1;
+        for (int dx = 0; dx <= 1 && match < 0; dx++){
+            for (int dy = 0; dy <= 1 && match < 0; dy++){
+                for (int dz = 0; dz <= 1 && match < 0; dz++){
+                    int first = cells.find(cellKey(cell[0]+dx*side[0], cell[1]+dy*side[1], cell[2]+dz*side[2]));
+                    for (int k = first; k >= 0 && match < 0; k = next[k]){
+                        const float* q = &raw.coords[3*kept[k]];
+                        float d2 = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+                        if (d2 <= eps2) match = k;
+                    }
+                }
+            }
+        }
+
+        if (match < 0){
+            match = int(kept.size());
+            kept.push_back(i);
+            int & head = cells.head(cellKey(cell[0], cell[1], cell[2]));
+            next[match] = head;
+            head = match;
+        }
+        remap[i] = match;
+    }
+
+    int nbRemoved = nbVertices - int(kept.size());
+    if (nbRemoved == 0) return 0;
+
+    // keep the merged vertices in place
+    for (int k = 0; k < int(kept.size()); k++){
+        for (int j = 0; j < 3; j++) raw.coords[3*k+j] = raw.coords[3*kept[k]+j];
+    }
+    raw.coords.resize(3*kept.size());
+
+    // remap the faces, drop the ones that lost a vertex and the ones now identical to a previous face
+    HeadTable faces;
+    std::vector<int> nextFace(raw.nbFaces(), -1);
+    std::vector<int> sorted, sortedOther;
+
+    int nbFaces = raw.nbFaces();
+    int nbIndices = 0;
+    int nbKeptFaces = 0;
+    // the offsets are compacted in place, so the start of a face is the end read for the previous one
+    int end = raw.offsets[0];
+    for (int i = 0; i < nbFaces; i++){
+        int begin = end;
+        end = raw.offsets[i+1];
+        int first = nbIndices;
+        for (int j = begin; j < end; j++){
+            int idx = remap[raw.indices[j]];
+            if (std::find(raw.indices.begin() + first, raw.indices.begin() + nbIndices, idx) != raw.indices.begin() + nbIndices) continue;
+            raw.indices[nbIndices++] = idx;
+        }
+        if (nbIndices - first < 3){
+            nbIndices = first;
+            continue;
+        }
+
+        sorted.assign(raw.indices.begin() + first, raw.indices.begin() + nbIndices);
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t key = utils::hashBytes(sorted.data(), sorted.size()*sizeof(int));
+        int & head = faces.head(key);
+        bool isDuplicate = false;
+        for (int k = head; k >= 0 && !isDuplicate; k = nextFace[k]){
+            sortedOther.assign(raw.indices.begin() + raw.offsets[k], raw.indices.begin() + raw.offsets[k+1]);
+            std::sort(sortedOther.begin(), sortedOther.end());
+            isDuplicate = sorted == sortedOther;
+        }
+        if (isDuplicate){
+            nbIndices = first;
+            continue;
+        }
+        nextFace[nbKeptFaces] = head;
+        head = nbKeptFaces;
+        raw.offsets[++nbKeptFaces] = nbIndices;
+    }
+    raw.indices.resize(nbIndices);
+    raw.offsets.resize(nbKeptFaces + 1);
+
+    return nbRemoved;
+}
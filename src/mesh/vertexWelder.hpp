@@ -0,0 +1,24 @@
+#pragma once
+
+#include "rawMesh.hpp"
+
+namespace mesh{
+
+/**
+ * A welder merging the duplicated vertices of a mesh read from a file with a uniform grid spatial hash
+*/
+class VertexWelder{
+
+    public:
+        /**
+         * Merge the vertices closer than a tolerance, remap the faces and remove the collapsed or duplicated ones
+         * A vertex is merged into a previous vertex of the file within the tolerance,
+         * so the merged vertices keep the order of the file and the result only depends on the file
+         * @param raw The mesh to weld
+         * @param tolerance The tolerance relative to the diagonal of the bounding box
+         * @return The number of removed vertices
+        */
+        static int weld(mesh::RawMesh & raw, float tolerance);
+};
+
+}
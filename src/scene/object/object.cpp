@@ -1,5 +1,3 @@
-#include <map>
-
 #include "object.hpp"
 
 void scene::Object::initDim(){
@@ -15,7 +13,10 @@ void scene::Object::initDim(){
 }
 
 scene::Object::Object(std::string obj){
-    mMesh = new mesh::Mesh(mesh::Mesh::loadOBJ(obj));
+    bool isPly = obj.size() >= 4 && obj.compare(obj.size() - 4, 4, ".ply") == 0;
+    mMesh = new mesh::Mesh(isPly ? mesh::Mesh::loadPLY(obj) : mesh::Mesh::loadOBJ(obj));
+    // quad meshes do not need the conversion
+    mIsQuad = mMesh->howManyTriangles() == 0;
     mTrans = glm::mat4(1.0f);
     // toQuadMesh();
     initVerticesAndIndices();
@@ -71,17 +72,17 @@ unsigned int scene::Object::nbLinesIndices() const { return mLinesIndices.size()
 
 void scene::Object::initVerticesAndIndices(){
     cleanLists();
-    // init a hash map to transform the mesh vertices' indices into values from 0 to nbVertices 
-    std::map<int, int> verticesIdx;
+    // the vertices are sent in the order of the mesh's list, so their slots are their indices
+    const mesh::AttributeChannel<float>* sFitmaps = mMesh->vertexAttributes().find<float>(mesh::Mesh::S_FITMAP);
+    const mesh::AttributeChannel<float>* mFitmaps = mMesh->vertexAttributes().find<float>(mesh::Mesh::M_FITMAP);
     for(int i=0; i<mMesh->mNbVertices; i++){
-	    verticesIdx[mMesh->mVertices[i]->mId] = i;
         // init the vertices
         glm::vec3 curVec = mMesh->mVertices[i]->toGlm();
         mVertices.push_back(curVec.x);
         mVertices.push_back(curVec.y);
         mVertices.push_back(curVec.z);
-        mVertices.push_back(mMesh->mVertices[i]->mSFitmap);
-        mVertices.push_back(mMesh->mVertices[i]->mMFitmap);
+        mVertices.push_back(sFitmaps ? (*sFitmaps)[i] : 0.0f);
+        mVertices.push_back(mFitmaps ? (*mFitmaps)[i] : 0.0f);
     }
 
     // init the indices
@@ -90,16 +91,16 @@ void scene::Object::initVerticesAndIndices(){
         // for quads
         if(verticesTmp.size() == 4){
             // for faces
-            mIndices.push_back(verticesIdx[verticesTmp[0]->mId]);
-            mIndices.push_back(verticesIdx[verticesTmp[1]->mId]);
-            mIndices.push_back(verticesIdx[verticesTmp[2]->mId]);
-            mIndices.push_back(verticesIdx[verticesTmp[0]->mId]);
-            mIndices.push_back(verticesIdx[verticesTmp[2]->mId]);
-            mIndices.push_back(verticesIdx[verticesTmp[3]->mId]);
+            mIndices.push_back(verticesTmp[0]->mSlot);
+            mIndices.push_back(verticesTmp[1]->mSlot);
+            mIndices.push_back(verticesTmp[2]->mSlot);
+            mIndices.push_back(verticesTmp[0]->mSlot);
+            mIndices.push_back(verticesTmp[2]->mSlot);
+            mIndices.push_back(verticesTmp[3]->mSlot);
             // for lines
             for(int j=0; j<4; j++){
-                int prev = verticesIdx[verticesTmp[j]->mId];
-                int next = verticesIdx[verticesTmp[(j+1) % 4]->mId];
+                int prev = verticesTmp[j]->mSlot;
+                int next = verticesTmp[(j+1) % 4]->mSlot;
                 // first triangle
                 mLinesIndices.push_back(prev);
                 mLinesIndices.push_back(next);
@@ -107,9 +108,9 @@ void scene::Object::initVerticesAndIndices(){
         // for triangles
         } else {
             for(int j=0; j<int(verticesTmp.size()); j++){
-                mIndices.push_back(verticesIdx[verticesTmp[j]->mId]);
-                mLinesIndices.push_back(verticesIdx[verticesTmp[j]->mId]);
-                mLinesIndices.push_back(verticesIdx[verticesTmp[(j+1)%3]->mId]);
+                mIndices.push_back(verticesTmp[j]->mSlot);
+                mLinesIndices.push_back(verticesTmp[j]->mSlot);
+                mLinesIndices.push_back(verticesTmp[(j+1)%3]->mSlot);
             }
         }
     }
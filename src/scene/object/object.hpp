@@ -143,7 +143,7 @@ class Object{
     public:
         /**
          * A constructor taking a file path as input
-         * @param obj The file to the object file we'll use to init  
+         * @param obj The file to the object file we'll use to init (obj or binary ply)
         */
         Object(std::string obj);
 
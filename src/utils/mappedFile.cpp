@@ -0,0 +1,38 @@
+#include "mappedFile.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+utils::MappedFile::MappedFile(const std::string & file){
+    mFd = open(file.c_str(), O_RDONLY);
+    struct stat st;
+    if (mFd < 0 || fstat(mFd, &st) != 0){
+        if (mFd >= 0) close(mFd);
+        std::fprintf(stderr, "Error, failed to open %s!\n", file.c_str());
+        throw std::invalid_argument("Need a file as input!\n");
+    }
+
+    mSize = size_t(st.st_size);
+    // mmap refuses empty files
+    if (mSize == 0) return;
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+    if (data == MAP_FAILED){
+        close(mFd);
+        std::fprintf(stderr, "Error, failed to map %s!\n", file.c_str());
+        throw std::invalid_argument("Need a file as input!\n");
+    }
+    // the file is read from the beginning to the end
+    madvise(data, mSize, MADV_SEQUENTIAL);
+    mData = static_cast<const char*>(data);
+}
+
+utils::MappedFile::~MappedFile(){
+    if (mData) munmap(const_cast<char*>(mData), mSize);
+    if (mFd >= 0) close(mFd);
+}
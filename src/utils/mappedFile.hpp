@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace utils{
+
+/**
+ * A read only view of a whole file mapped in memory
+*/
+class MappedFile{
+
+    private:
+        /**
+         * The first byte of the file
+        */
+        const char* mData = nullptr;
+
+        /**
+         * The size of the file in bytes
+        */
+        size_t mSize = 0;
+
+        /**
+         * The file descriptor
+        */
+        int mFd = -1;
+
+    public:
+        /**
+         * Map a file in memory
+         * @param file The path to the file
+         * @exception Invalid_Argument if the file can't be opened
+        */
+        MappedFile(const std::string & file);
+
+        /**
+         * Unmap the file
+        */
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator = (const MappedFile &) = delete;
+
+        /**
+         * Get the beginning of the file
+         * @return A pointer to the first byte
+        */
+        const char* begin() const {return mData;};
+
+        /**
+         * Get the end of the file
+         * @return A pointer past the last byte
+        */
+        const char* end() const {return mData + mSize;};
+
+        /**
+         * Get the size of the file
+         * @return The number of bytes in the file
+        */
+        size_t size() const {return mSize;};
+};
+
+};
@@ -1,5 +1,11 @@
 #include "utils.hpp"
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 float utils::maxFloat(std::vector<float> floats){
     float max = -INFINITY;
@@ -8,3 +14,161 @@ float utils::maxFloat(std::vector<float> floats){
     }
     return max;
 }
+
+int utils::nbThreads(){
+    int nb = int(std::thread::hardware_concurrency());
+    return nb > 0 ? nb : 1;
+}
+
+namespace{
+
+/**
+ * A loop shared between the calling thread and the workers
+*/
+struct ParallelLoop{
+    int nbTasks;
+    const std::function<void(int)> * task;
+    std::atomic<int> next{0};
+    std::exception_ptr error = nullptr;
+    std::mutex errorMutex;
+    int nbActiveWorkers = 0;
+};
+
+/**
+ * Tells if the current thread is a worker or is running a loop, its nested loops are run sequentially
+*/
+thread_local bool inParallelLoop = false;
+
+/**
+ * Run the tasks of a loop until there is none left to take
+ * @param loop The loop
+*/
+void runTasks(ParallelLoop & loop){
+    int i;
+    while((i = loop.next++) < loop.nbTasks){
+        try{
+            (*loop.task)(i);
+        } catch(...){
+            std::lock_guard<std::mutex> lock(loop.errorMutex);
+            if(!loop.error) loop.error = std::current_exception();
+            loop.next = loop.nbTasks;
+        }
+    }
+}
+
+/**
+ * Threads started once and woken up for each loop, so a loop doesn't pay for creating and joining threads
+*/
+class WorkerPool{
+
+    public:
+        /**
+         * Start the workers
+         * @param nbWorkers The number of workers, the calling thread of each loop works with them
+        */
+        WorkerPool(int nbWorkers){
+            for(int i=0; i<nbWorkers; i++) mWorkers.emplace_back([this](){ work(); });
+        }
+
+        /**
+         * Stop and join the workers
+        */
+        ~WorkerPool(){
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mWakeUp.notify_all();
+            for(std::thread & worker : mWorkers) worker.join();
+        }
+
+        /**
+         * Run a loop with the workers and the calling thread
+         * @param loop The loop
+         * @return False if the workers are already busy with another thread's loop
+        */
+        bool run(ParallelLoop & loop){
+            std::unique_lock<std::mutex> busy(mBusy, std::try_to_lock);
+            if(!busy.owns_lock()) return false;
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mLoop = &loop;
+                mGeneration++;
+            }
+            mWakeUp.notify_all();
+            runTasks(loop);
+
+            // no worker can join the loop once it is unset, wait for the ones still running a task
+            std::unique_lock<std::mutex> lock(mMutex);
+            mDone.wait(lock, [&](){ return loop.nbActiveWorkers == 0; });
+            mLoop = nullptr;
+            return true;
+        }
+
+    private:
+        void work(){
+            inParallelLoop = true;
+            uint64_t generation = 0;
+            while(true){
+                ParallelLoop* loop;
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mWakeUp.wait(lock, [&](){ return mStop || mGeneration != generation; });
+                    if(mStop) return;
+                    generation = mGeneration;
+                    loop = mLoop;
+                    if(!loop) continue;
+                    loop->nbActiveWorkers++;
+                }
+                runTasks(*loop);
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    loop->nbActiveWorkers--;
+                }
+                mDone.notify_all();
+            }
+        }
+
+        std::vector<std::thread> mWorkers;
+        std::mutex mBusy;
+        std::mutex mMutex;
+        std::condition_variable mWakeUp;
+        std::condition_variable mDone;
+        ParallelLoop* mLoop = nullptr;
+        uint64_t mGeneration = 0;
+        bool mStop = false;
+};
+
+}
+
+void utils::parallelFor(int nbTasks, const std::function<void(int)> & task){
+    if(nbTasks <= 1 || nbThreads() <= 1 || inParallelLoop){
+        for(int i=0; i<nbTasks; i++) task(i);
+        return;
+    }
+
+    // started on the first loop, the calling thread is the last worker
+    static WorkerPool pool(nbThreads() - 1);
+
+    ParallelLoop loop;
+    loop.nbTasks = nbTasks;
+    loop.task = &task;
+    inParallelLoop = true;
+    bool done = pool.run(loop);
+    inParallelLoop = false;
+
+    // the workers are running another thread's loop, run this one alone
+    if(!done) runTasks(loop);
+
+    if(loop.error) std::rethrow_exception(loop.error);
+}
+
+uint64_t utils::hashBytes(const void* data, size_t size, uint64_t hash){
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<size; i++){
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
@@ -4,9 +4,36 @@
 #include "constants.hpp"
 
 #include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
 
 namespace utils{
 
 float maxFloat(std::vector<float> floats);
 
-};
\ No newline at end of file
+/**
+ * Get the number of threads used by the parallel loops
+ * @return The number of hardware threads (at least one)
+*/
+int nbThreads();
+
+/**
+ * Run a task for every index in [0, nbTasks) across the available threads
+ * The worker threads are started by the first call and reused, the loops nested in a task run sequentially
+ * @param nbTasks The number of tasks
+ * @param task The task to run, taking the index of the task as parameter
+ * @exception Rethrows the first exception thrown by a task
+*/
+void parallelFor(int nbTasks, const std::function<void(int)> & task);
+
+/**
+ * Hash bytes with 64 bits FNV-1a
+ * @param data The bytes to hash
+ * @param size The number of bytes
+ * @param hash The hash to continue, the FNV offset basis to start a new one
+ * @return The hash of the bytes
+*/
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL);
+
+};